@@ -0,0 +1,59 @@
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench {
+
+/**
+ * @brief a xorshift generator, so that every run (and every container) sees the same sequence of keys
+ *
+ */
+class random {
+  public:
+    explicit random(uint64_t seed = 20230409) : state(seed) {}
+    uint64_t operator()() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+  private:
+    uint64_t state;
+};
+
+/**
+ * @brief run the function several times and report the best wall time in milliseconds
+ *
+ * @param name
+ * @param func
+ * @param rounds
+ * @return double
+ */
+template <class Func> double measure(const char *name, Func func, int rounds = 3) {
+    double best = 0;
+    for (int i = 0; i < rounds; i++) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto stop = std::chrono::steady_clock::now();
+        double cost = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (i == 0 || cost < best)
+            best = cost;
+    }
+    printf("%-48s %10.2f ms\n", name, best);
+    return best;
+}
+
+/**
+ * @brief prevent the compiler from optimizing away a computed value
+ *
+ * @param value
+ */
+template <class T> void keep(const T &value) { asm volatile("" : : "g"(&value) : "memory"); }
+
+} // namespace bench
+
+#endif
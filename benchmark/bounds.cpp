@@ -0,0 +1,44 @@
+#include <cstdio>
+#include <map>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 100000;
+const int STEPS = 2000000;
+
+// Take the earliest deadline and schedule a later one, peeking at the latest deadline on the way
+template <class Map> void take_minimum() {
+    Map m;
+    bench::random gen;
+    long long now = 0, sum = 0;
+    for (int i = 0; i < N; i++)
+        m[gen() % (16 * N)] = i;
+    for (int i = 0; i < STEPS; i++) {
+        auto it = m.begin();
+        now = it->first;
+        sum += it->second + (--m.end())->first;
+        m.erase(it);
+        m[now + 1 + gen() % (16 * N)] = i;
+    }
+    bench::keep(sum);
+}
+
+// Read the bounds only, which used to walk the whole height
+template <class Map> void peek_bounds() {
+    Map m;
+    for (int i = 0; i < N; i++)
+        m[i] = i;
+    long long sum = 0;
+    for (int i = 0; i < STEPS * 5; i++)
+        sum += m.begin()->second + (--m.end())->second;
+    bench::keep(sum);
+}
+
+int main() {
+    bench::measure("sjtu::map 100K deadlines, 2M take-minimum steps", take_minimum<sjtu::map<long long, int>>);
+    bench::measure("std::map  100K deadlines, 2M take-minimum steps", take_minimum<std::map<long long, int>>);
+    bench::measure("sjtu::map 100K keys, 10M begin() and --end()", peek_bounds<sjtu::map<int, int>>);
+    bench::measure("std::map  100K keys, 10M begin() and --end()", peek_bounds<std::map<int, int>>);
+    return 0;
+}
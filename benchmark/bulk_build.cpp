@@ -0,0 +1,44 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+
+template <class Map> void load_by_insert(const std::vector<sjtu::pair<int, int>> &snapshot) {
+    Map m;
+    for (const auto &item : snapshot)
+        m.insert(item);
+    bench::keep(m);
+}
+
+template <class Map> void load_sorted(const std::vector<sjtu::pair<int, int>> &snapshot) {
+    Map m(snapshot.begin(), snapshot.end());
+    bench::keep(m);
+}
+
+template <class Map> void scan(const Map &m) {
+    long long sum = 0;
+    for (auto it = m.cbegin(); it != m.cend(); ++it)
+        sum += it->second;
+    bench::keep(sum);
+}
+
+int main() {
+    std::vector<sjtu::pair<int, int>> snapshot;
+    for (int i = 0; i < N; i++)
+        snapshot.push_back(sjtu::pair<int, int>(i * 2, i));
+    typedef sjtu::map<int, int> Map;
+    typedef sjtu::ranked_map<int, int> Ranked;
+    bench::measure("sjtu::map        load 1M sorted, insert", [&] { load_by_insert<Map>(snapshot); });
+    bench::measure("sjtu::map        load 1M sorted, bulk", [&] { load_sorted<Map>(snapshot); });
+    bench::measure("sjtu::ranked_map load 1M sorted, insert", [&] { load_by_insert<Ranked>(snapshot); });
+    bench::measure("sjtu::ranked_map load 1M sorted, bulk", [&] { load_sorted<Ranked>(snapshot); });
+    Map inserted, built(snapshot.begin(), snapshot.end());
+    for (const auto &item : snapshot)
+        inserted.insert(item);
+    bench::measure("sjtu::map        scan 1M, built by insert", [&] { scan(inserted); });
+    bench::measure("sjtu::map        scan 1M, built in bulk", [&] { scan(built); });
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <cstdio>
+#include <iterator>
+#include <map>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 200000;
+const int QUERIES = 2000;
+
+// Counts the keys between two random bounds with distance(), as a range-count report does.
+// Found by argument-dependent lookup, it takes O(log n) on a ranked map; std::distance walks the range.
+template <class Map, bool Adl> void count(const char *name) {
+    Map m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[gen() % (4 * N)] = i;
+    bench::measure(name, [&] {
+        long long sum = 0;
+        for (int i = 0; i < QUERIES; i++) {
+            int lo = gen() % (4 * N), hi = lo + gen() % (4 * N - lo);
+            if constexpr (Adl) {
+                using std::distance;
+                sum += distance(m.lower_bound(lo), m.lower_bound(hi));
+            } else {
+                sum += std::distance(m.lower_bound(lo), m.lower_bound(hi));
+            }
+        }
+        bench::keep(sum);
+    });
+}
+
+int main() {
+    count<sjtu::ranked_map<int, int>, true>("sjtu::ranked_map distance      2K ranges of 200K");
+    count<sjtu::ranked_map<int, int>, false>("sjtu::ranked_map std::distance 2K ranges of 200K");
+    count<sjtu::map<int, int>, true>("sjtu::map distance             2K ranges of 200K");
+    count<std::map<int, int>, true>("std::map distance              2K ranges of 200K");
+    return 0;
+}
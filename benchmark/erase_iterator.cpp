@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+
+// Drop the expired sessions while iterating, as a cache eviction pass does
+template <class Map> void evict() {
+    Map m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[i] = gen() % 4;
+    for (int pass = 0; pass < 3; pass++)
+        for (auto it = m.begin(); it != m.end();) {
+            if (it->second == pass)
+                it = m.erase(it);
+            else
+                ++it;
+        }
+    bench::keep(m.size());
+}
+
+// The same with string keys, which the old erase(iterator) compared on every level of its descent
+template <class Map> void evict_strings() {
+    Map m;
+    bench::random gen;
+    for (int i = 0; i < N / 4; i++)
+        m["session/" + std::to_string(gen())] = gen() % 4;
+    for (int pass = 0; pass < 3; pass++)
+        for (auto it = m.begin(); it != m.end();) {
+            if (it->second == pass)
+                it = m.erase(it);
+            else
+                ++it;
+        }
+    bench::keep(m.size());
+}
+
+int main() {
+    bench::measure("sjtu::map<int, int>    1M, erase while iterating", evict<sjtu::map<int, int>>);
+    bench::measure("std::map<int, int>     1M, erase while iterating", evict<std::map<int, int>>);
+    bench::measure("sjtu::map<string, int> 250K, erase while iterating", evict_strings<sjtu::map<std::string, int>>);
+    bench::measure("std::map<string, int>  250K, erase while iterating", evict_strings<std::map<std::string, int>>);
+    return 0;
+}
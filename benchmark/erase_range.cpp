@@ -0,0 +1,38 @@
+#include <cstdio>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int WINDOW = 100000;
+const int SWEEP = 10000;
+
+// Keys are timestamps, and the sweeper drops the ones older than the window every SWEEP insertions
+template <class Map> void sweep_by_element() {
+    Map m;
+    for (int i = 0; i < N; i++) {
+        m[i] = i;
+        if (i % SWEEP == 0)
+            while (m.begin()->first < i - WINDOW)
+                m.erase(m.begin());
+    }
+    bench::keep(m);
+}
+
+template <class Map> void sweep_by_range() {
+    Map m;
+    for (int i = 0; i < N; i++) {
+        m[i] = i;
+        if (i % SWEEP == 0)
+            m.erase_range(0, i - WINDOW);
+    }
+    bench::keep(m);
+}
+
+int main() {
+    typedef sjtu::map<int, int> Map;
+    bench::measure("sjtu::map        1M timestamps, erase(iterator)", sweep_by_element<Map>);
+    bench::measure("sjtu::map        1M timestamps, erase_range", sweep_by_range<Map>);
+    bench::measure("sjtu::ranked_map 1M timestamps, erase_range", sweep_by_range<sjtu::ranked_map<int, int>>);
+    return 0;
+}
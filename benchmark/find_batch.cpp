@@ -0,0 +1,64 @@
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 10000000;
+const int PROBES = 4000000;
+const int BATCH = 1024;
+
+// Probes a 10M-entry map with random keys in batches of 1024, as the join operator does.
+// Half of the keys are in the map.
+void probe(const char *name, bool batched) {
+    sjtu::map<int, int> m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[gen() % (2 * N)] = i;
+    std::vector<int> keys(PROBES);
+    for (int &key : keys)
+        key = gen() % (2 * N);
+    std::vector<sjtu::map<int, int>::iterator> out(BATCH);
+    bench::measure(name, [&] {
+        long long sum = 0;
+        for (int i = 0; i < PROBES; i += BATCH) {
+            if (batched) {
+                m.find_batch(keys.data() + i, BATCH, out.data());
+            } else {
+                for (int j = 0; j < BATCH; j++)
+                    out[j] = m.find(keys[i + j]);
+            }
+            for (int j = 0; j < BATCH; j++)
+                if (out[j] != m.end())
+                    sum += out[j]->second;
+        }
+        bench::keep(sum);
+    });
+}
+
+void probe_std(const char *name) {
+    std::map<int, int> m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[gen() % (2 * N)] = i;
+    std::vector<int> keys(PROBES);
+    for (int &key : keys)
+        key = gen() % (2 * N);
+    bench::measure(name, [&] {
+        long long sum = 0;
+        for (int key : keys) {
+            auto it = m.find(key);
+            if (it != m.end())
+                sum += it->second;
+        }
+        bench::keep(sum);
+    });
+}
+
+int main() {
+    probe("sjtu::map find_batch 4M probes of 10M", true);
+    probe("sjtu::map find       4M probes of 10M", false);
+    probe_std("std::map find        4M probes of 10M");
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <map>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int LOOKUPS = 5000000;
+
+// Looks up keys on a random walk with steps of up to SPAN keys, as the local access patterns do.
+// The finger searches start from the last element found, and the others from the root.
+template <class Map, bool Finger> void walk(const char *name, int span) {
+    Map m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[gen() % (4 * N)] = i;
+    bench::measure(name, [&] {
+        long long sum = 0;
+        auto finger = m.begin();
+        for (int i = 0, key = 2 * N; i < LOOKUPS; i++) {
+            key += (int)(gen() % (2 * span + 1)) - span;
+            if (key < 0 || key >= 4 * N)
+                key = 2 * N;
+            auto it = m.end();
+            if constexpr (Finger)
+                it = m.lower_bound(finger, key);
+            else
+                it = m.lower_bound(key);
+            if (it != m.end())
+                sum += it->second, finger = it;
+        }
+        bench::keep(sum);
+    });
+}
+
+int main() {
+    walk<sjtu::map<int, int>, true>("sjtu::map finger 5M lookups of 1M, steps of 16   ", 16);
+    walk<sjtu::map<int, int>, false>("sjtu::map root   5M lookups of 1M, steps of 16   ", 16);
+    walk<std::map<int, int>, false>("std::map         5M lookups of 1M, steps of 16   ", 16);
+    walk<sjtu::map<int, int>, true>("sjtu::map finger 5M lookups of 1M, steps of 4096 ", 4096);
+    walk<sjtu::map<int, int>, false>("sjtu::map root   5M lookups of 1M, steps of 4096 ", 4096);
+    walk<sjtu::map<int, int>, true>("sjtu::map finger 5M lookups of 1M, steps of 256K ", 1 << 18);
+    walk<sjtu::map<int, int>, false>("sjtu::map root   5M lookups of 1M, steps of 256K ", 1 << 18);
+    return 0;
+}
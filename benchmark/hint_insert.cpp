@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+
+// Mostly increasing keys, where one in 16 arrives a little late
+std::vector<int> ingest_keys() {
+    std::vector<int> keys(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        keys[i] = i * 4;
+    for (int i = 16; i < N; i += 16)
+        keys[i] -= 4 * (1 + gen() % 8) + 2;
+    return keys;
+}
+
+template <class Map> void insert_plain(const std::vector<int> &keys) {
+    Map m;
+    for (int key : keys)
+        m.insert(typename Map::value_type(key, key));
+    bench::keep(m);
+}
+
+template <class Map> void insert_hinted(const std::vector<int> &keys) {
+    Map m;
+    for (int key : keys)
+        m.insert(m.cend(), typename Map::value_type(key, key));
+    bench::keep(m);
+}
+
+int main() {
+    std::vector<int> keys = ingest_keys();
+    typedef sjtu::map<int, int> Map;
+    bench::measure("sjtu::map        1M nearly sorted, insert", [&] { insert_plain<Map>(keys); });
+    bench::measure("sjtu::map        1M nearly sorted, insert(end(), v)", [&] { insert_hinted<Map>(keys); });
+    bench::measure("sjtu::ranked_map 1M nearly sorted, insert(end(), v)",
+                   [&] { insert_hinted<sjtu::ranked_map<int, int>>(keys); });
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 200000;
+
+typedef sjtu::map<std::string, std::string> Map;
+
+Map build(const std::vector<std::string> &keys) {
+    Map res;
+    for (const auto &key : keys)
+        res[key] = key;
+    return res;
+}
+
+int main() {
+    std::vector<std::string> keys(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        keys[i] = "session/" + std::to_string(gen()) + "/user/" + std::to_string(i);
+
+    // Both build their inputs from scratch, so that only the insertion differs.
+    // The key of a value_type is const, so only a pair<Key, T> can have its key moved into the node.
+    bench::measure("sjtu::map<string, string> insert copied keys", [&] {
+        std::vector<std::string> source(keys), values(keys);
+        Map m;
+        for (int i = 0; i < N; i++)
+            m.insert(Map::value_type(source[i], values[i]));
+        bench::keep(m);
+    });
+    bench::measure("sjtu::map<string, string> insert moved keys", [&] {
+        std::vector<std::string> source(keys), values(keys);
+        Map m;
+        for (int i = 0; i < N; i++)
+            m.insert(sjtu::pair<std::string, std::string>(std::move(source[i]), std::move(values[i])));
+        bench::keep(m);
+    });
+    Map built = build(keys);
+    bench::measure("sjtu::map<string, string> copy 200K", [&] {
+        Map copy(built);
+        bench::keep(copy);
+    });
+    bench::measure("sjtu::map<string, string> move 200K and back", [&] {
+        Map moved(std::move(built));
+        built = std::move(moved);
+        bench::keep(built);
+    });
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 200000;
+
+typedef sjtu::map<std::string, std::string> Map;
+
+// Promote every staged item to the live map
+template <class Func> void promote(const std::vector<std::string> &keys, Func func) {
+    Map staging, live;
+    for (size_t i = 0; i < keys.size(); i++)
+        (i % 2 ? staging : live)[keys[i]] = keys[i] + keys[i];
+    func(staging, live);
+    bench::keep(live);
+}
+
+int main() {
+    std::vector<std::string> keys(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        keys[i] = "item/" + std::to_string(gen()) + "/" + std::to_string(i);
+
+    bench::measure("sjtu::map<string, string> promote 100K, insert + erase", [&] {
+        promote(keys, [](Map &staging, Map &live) {
+            while (!staging.empty()) {
+                auto it = staging.begin();
+                live.insert(*it);
+                staging.erase(it);
+            }
+        });
+    });
+    bench::measure("sjtu::map<string, string> promote 100K, extract + insert", [&] {
+        promote(keys, [](Map &staging, Map &live) {
+            while (!staging.empty())
+                live.insert(staging.extract(staging.begin()));
+        });
+    });
+    bench::measure("sjtu::map<string, string> promote 100K, merge", [&] {
+        promote(keys, [](Map &staging, Map &live) { live.merge(staging); });
+    });
+    return 0;
+}
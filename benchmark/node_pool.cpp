@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int CHURN_SIZE = 100000;
+const int CHURN_ROUNDS = 1000000;
+
+template <class Map> void insert_heavy(const std::vector<int> &keys) {
+    Map m;
+    for (int key : keys)
+        m[key] = key;
+    bench::keep(m);
+}
+
+template <class Map> void churn_heavy(const std::vector<int> &keys) {
+    Map m;
+    for (int i = 0; i < CHURN_SIZE; i++)
+        m[keys[i]] = i;
+    // Erase the oldest key and insert a new one, so that the size stays stable
+    for (int i = CHURN_SIZE; i < CHURN_ROUNDS; i++) {
+        m.erase(m.find(keys[i - CHURN_SIZE]));
+        m[keys[i]] = i;
+    }
+    bench::keep(m);
+}
+
+int main() {
+    std::vector<int> sequential(N), shuffled(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        sequential[i] = shuffled[i] = i;
+    for (int i = N - 1; i > 0; i--)
+        std::swap(shuffled[i], shuffled[gen() % (i + 1)]);
+
+    bench::measure("sjtu::map insert 1M sequential", [&] { insert_heavy<sjtu::map<int, int>>(sequential); });
+    bench::measure("std::map  insert 1M sequential", [&] { insert_heavy<std::map<int, int>>(sequential); });
+    bench::measure("sjtu::map insert 1M shuffled", [&] { insert_heavy<sjtu::map<int, int>>(shuffled); });
+    bench::measure("std::map  insert 1M shuffled", [&] { insert_heavy<std::map<int, int>>(shuffled); });
+    bench::measure("sjtu::map churn 100K live / 900K replaced", [&] { churn_heavy<sjtu::map<int, int>>(shuffled); });
+    bench::measure("std::map  churn 100K live / 900K replaced", [&] { churn_heavy<std::map<int, int>>(shuffled); });
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int LIVE = 100000;
+
+template <class Map> void insert_erase(const std::vector<int> &keys) {
+    Map m;
+    for (int i = 0; i < N; i++) {
+        m[keys[i]] = i;
+        if (i >= LIVE)
+            m.erase(m.find(keys[i - LIVE]));
+    }
+    bench::keep(m);
+}
+
+int main() {
+    std::vector<int> keys(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        keys[i] = i;
+    for (int i = N - 1; i > 0; i--)
+        std::swap(keys[i], keys[gen() % (i + 1)]);
+
+    printf("node size: sjtu::map<int, int> %zu bytes, sjtu::ranked_map<int, int> %zu bytes\n",
+           sizeof(sjtu::map<int, int>::tnode), sizeof(sjtu::ranked_map<int, int>::tnode));
+    printf("node size: sjtu::map<short, short> %zu bytes, sjtu::ranked_map<short, short> %zu bytes\n",
+           sizeof(sjtu::map<short, short>::tnode), sizeof(sjtu::ranked_map<short, short>::tnode));
+    bench::measure("sjtu::map        1M insert + 900K erase", [&] { insert_erase<sjtu::map<int, int>>(keys); });
+    bench::measure("sjtu::ranked_map 1M insert + 900K erase", [&] { insert_erase<sjtu::ranked_map<int, int>>(keys); });
+    return 0;
+}
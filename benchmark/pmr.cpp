@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <memory_resource>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int REQUESTS = 2000;
+const int ENTRIES = 1000;
+const int QUERIES = 1000;
+const int LARGE = 1000000;
+
+/**
+ * @brief build a map, query it and throw it away, like serving a request
+ *
+ * @param m an empty map
+ * @param keys
+ * @return long long
+ */
+template <class Map> long long serve(Map &m, const std::vector<int> &keys) {
+    long long sum = 0;
+    for (int i = 0; i < ENTRIES; i++)
+        m[keys[i]] = i;
+    for (int i = 0; i < QUERIES; i++)
+        sum += m.count(keys[(i * 7) % ENTRIES]);
+    return sum;
+}
+
+int main() {
+    std::vector<int> keys(ENTRIES);
+    bench::random gen;
+    for (int i = 0; i < ENTRIES; i++)
+        keys[i] = gen() % 1000000;
+
+    bench::measure("sjtu::map (new/delete)", [&] {
+        long long sum = 0;
+        for (int i = 0; i < REQUESTS; i++) {
+            sjtu::map<int, int> m;
+            sum += serve(m, keys);
+        }
+        bench::keep(sum);
+    });
+    bench::measure("sjtu::pmr::map (new_delete_resource)", [&] {
+        long long sum = 0;
+        for (int i = 0; i < REQUESTS; i++) {
+            sjtu::pmr::map<int, int> m(std::pmr::new_delete_resource());
+            sum += serve(m, keys);
+        }
+        bench::keep(sum);
+    });
+    bench::measure("sjtu::pmr::map (monotonic_buffer_resource)", [&] {
+        long long sum = 0;
+        std::vector<char> buffer(1 << 20);
+        for (int i = 0; i < REQUESTS; i++) {
+            std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+            sjtu::pmr::map<int, int> m(&arena);
+            sum += serve(m, keys);
+        }
+        bench::keep(sum);
+    });
+
+    // Only the destruction of a large map is measured here
+    auto destruct = [&](const char *name, auto make) {
+        auto *m = make();
+        for (int i = 0; i < LARGE; i++)
+            (*m)[i * 7 % LARGE] = i;
+        bench::measure(name, [&] { delete m; }, 1);
+    };
+    destruct("destruct 1M sjtu::map (new/delete)", [] { return new sjtu::map<int, int>; });
+    std::pmr::monotonic_buffer_resource arena;
+    destruct("destruct 1M sjtu::pmr::map (monotonic_buffer_resource)",
+             [&] { return new sjtu::pmr::map<int, int>(&arena); });
+    return 0;
+}
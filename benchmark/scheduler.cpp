@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int JOBS = 100000;
+const int STEPS = 2000000;
+const long long SLOTS = 1 << 20;
+
+// A job runs at time key / SLOTS, and its id is key % SLOTS, which keeps the keys unique.
+// The scheduler takes the earliest job, and runs it again after a random delay.
+long long reschedule(long long key, bench::random &gen) {
+    return (key / SLOTS + 1 + gen() % 1000) * SLOTS + key % SLOTS;
+}
+
+void with_pop_front() {
+    sjtu::map<long long, int> jobs;
+    bench::random gen;
+    for (int i = 0; i < JOBS; i++)
+        jobs[(long long)(gen() % 1000) * SLOTS + i] = i;
+    long long sum = 0;
+    for (int i = 0; i < STEPS; i++) {
+        long long key = jobs.front().first;
+        int job = jobs.front().second;
+        jobs.pop_front();
+        sum += job;
+        jobs[reschedule(key, gen)] = job;
+    }
+    bench::keep(sum);
+}
+
+template <class Map> void with_begin_erase() {
+    Map jobs;
+    bench::random gen;
+    for (int i = 0; i < JOBS; i++)
+        jobs[(long long)(gen() % 1000) * SLOTS + i] = i;
+    long long sum = 0;
+    for (int i = 0; i < STEPS; i++) {
+        auto it = jobs.begin();
+        long long key = it->first;
+        int job = it->second;
+        jobs.erase(it);
+        sum += job;
+        jobs[reschedule(key, gen)] = job;
+    }
+    bench::keep(sum);
+}
+
+void with_priority_queue() {
+    std::priority_queue<long long, std::vector<long long>, std::greater<long long>> jobs;
+    bench::random gen;
+    for (int i = 0; i < JOBS; i++)
+        jobs.push((long long)(gen() % 1000) * SLOTS + i);
+    long long sum = 0;
+    for (int i = 0; i < STEPS; i++) {
+        long long key = jobs.top();
+        jobs.pop();
+        sum += key % SLOTS;
+        jobs.push(reschedule(key, gen));
+    }
+    bench::keep(sum);
+}
+
+int main() {
+    bench::measure("sjtu::map front/pop_front 100K jobs, 2M steps", with_pop_front);
+    bench::measure("sjtu::map begin/erase     100K jobs, 2M steps", with_begin_erase<sjtu::map<long long, int>>);
+    bench::measure("std::map begin/erase      100K jobs, 2M steps", with_begin_erase<std::map<long long, int>>);
+    bench::measure("std::priority_queue       100K jobs, 2M steps", with_priority_queue);
+    return 0;
+}
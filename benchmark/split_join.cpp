@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int SHARDS = 16;
+const int ROUNDS = 100;
+
+// Move the upper half of one shard to the next one, element by element
+template <class Map> void rebalance_by_element(std::vector<Map> &shards, int from, int bound) {
+    auto it = shards[from].lower_bound(bound);
+    while (it != shards[from].end()) {
+        shards[from + 1].insert(*it);
+        auto cur = it++;
+        shards[from].erase(cur);
+    }
+}
+
+template <class Map> void rebalance_by_split(std::vector<Map> &shards, int from, int bound) {
+    Map upper = shards[from].split(bound);
+    shards[from + 1].join(upper);
+}
+
+template <class Map, class Func> void rebalance(Func func) {
+    const int width = N / SHARDS;
+    std::vector<Map> shards(SHARDS);
+    for (int i = 0; i < N; i++)
+        shards[i / width][i] = i;
+    bench::random gen;
+    // Shift the boundary between two neighbouring shards back and forth
+    for (int round = 0; round < ROUNDS; round++) {
+        int from = gen() % (SHARDS - 1);
+        int bound = from * width + gen() % width;
+        func(shards, from, bound);
+        Map upper = shards[from + 1].split((from + 1) * width);
+        shards[from].join(shards[from + 1]);
+        shards[from + 1].join(upper);
+    }
+    bench::keep(shards);
+}
+
+int main() {
+    typedef sjtu::map<int, int> Map;
+    typedef sjtu::ranked_map<int, int> Ranked;
+    bench::measure("sjtu::map        16 shards, 100 moves, erase/insert",
+                   [] { rebalance<Map>(rebalance_by_element<Map>); });
+    bench::measure("sjtu::map        16 shards, 100 moves, split/join", [] { rebalance<Map>(rebalance_by_split<Map>); });
+    bench::measure("sjtu::ranked_map 16 shards, 100 moves, split/join",
+                   [] { rebalance<Ranked>(rebalance_by_split<Ranked>); });
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <cstdio>
+#include <map>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 1000000;
+const int SCANS = 10;
+
+// Fill the map, then scan the whole table forwards and backwards, as the nightly jobs do.
+// Filled in order, the nodes lie in memory in the order of the scan, so the walk itself dominates;
+// filled at random, every step is a cache miss either way.
+template <class Map> void scan(const char *name, bool random) {
+    Map m;
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        m[random ? gen() % (4 * N) : i] = i;
+    bench::measure(name, [&] {
+        long long sum = 0;
+        for (int i = 0; i < SCANS; i++) {
+            for (auto it = m.begin(); it != m.end(); ++it)
+                sum += it->second;
+            for (auto it = m.end(); it != m.begin();)
+                sum -= (--it)->first;
+        }
+        bench::keep(sum);
+    });
+}
+
+int main() {
+    scan<sjtu::map<int, int>>("sjtu::map          1M in order, 10 scans each way", false);
+    scan<sjtu::threaded_map<int, int>>("sjtu::threaded_map 1M in order, 10 scans each way", false);
+    scan<std::map<int, int>>("std::map           1M in order, 10 scans each way", false);
+    scan<sjtu::map<int, int>>("sjtu::map          1M at random, 10 scans each way", true);
+    scan<sjtu::threaded_map<int, int>>("sjtu::threaded_map 1M at random, 10 scans each way", true);
+    scan<std::map<int, int>>("std::map           1M at random, 10 scans each way", true);
+    return 0;
+}
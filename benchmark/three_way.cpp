@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "class-bint.hpp"
+#include "map.hpp"
+
+const int N = 100000;
+const int LOOKUPS = 1000000;
+// A Bint always takes 8 KB, so fewer of them fit in memory
+const int BINT_N = 10000;
+
+// Insert the first half of the keys, look up random ones (so half of the lookups miss), and erase them all
+template <class Map, class Key> void workload(const std::vector<Key> &keys, const std::vector<int> &probes) {
+    Map m;
+    int n = keys.size() / 2;
+    for (int i = 0; i < n; i++)
+        m[keys[i]] = i;
+    long long sum = 0;
+    for (int probe : probes)
+        sum += m.count(keys[probe]);
+    for (int i = 0; i < n; i++)
+        m.erase(keys[i]);
+    bench::keep(sum + m.size());
+}
+
+int main() {
+    bench::random gen;
+    // Strings sharing a long prefix, which std::string::compare() walks through once instead of twice
+    std::vector<std::string> words(2 * N);
+    std::vector<int> word_probes(LOOKUPS);
+    for (int i = 0; i < 2 * N; i++)
+        words[i] = "/var/lib/storage/objects/bucket-" + std::to_string(gen() % 100) + "/" + std::to_string(gen());
+    for (int i = 0; i < LOOKUPS; i++)
+        word_probes[i] = gen() % (2 * N);
+    bench::measure("sjtu::map<string, int> insert/find/erase", [&] { workload<sjtu::map<std::string, int>>(words, word_probes); });
+    bench::measure("std::map<string, int>  insert/find/erase", [&] { workload<std::map<std::string, int>>(words, word_probes); });
+
+    // Big integers, which only have operator<, so the tree compares once on each level and checks the equality at the end
+    std::vector<Util::Bint> numbers;
+    std::vector<int> number_probes(LOOKUPS);
+    for (int i = 0; i < 2 * BINT_N; i++)
+        numbers.push_back(Util::Bint(std::to_string(gen()) + std::to_string(gen()) + std::to_string(gen())));
+    for (int i = 0; i < LOOKUPS; i++)
+        number_probes[i] = gen() % (2 * BINT_N);
+    bench::measure("sjtu::map<Bint, int>   insert/find/erase", [&] { workload<sjtu::map<Util::Bint, int>>(numbers, number_probes); });
+    bench::measure("std::map<Bint, int>    insert/find/erase", [&] { workload<std::map<Util::Bint, int>>(numbers, number_probes); });
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+#include "map.hpp"
+
+const int N = 100000;
+const int LOOKUPS = 1000000;
+
+// Look up the routes by string_views into a request buffer, as a router does
+template <class Compare>
+void route(const sjtu::map<std::string, int, Compare> &m, const std::vector<std::string_view> &requests) {
+    long long sum = 0;
+    for (auto request : requests) {
+        if constexpr (std::is_same<Compare, std::less<>>::value)
+            sum += m.count(request);
+        else
+            sum += m.count(std::string(request));
+    }
+    bench::keep(sum);
+}
+
+int main() {
+    std::vector<std::string> routes(N);
+    bench::random gen;
+    for (int i = 0; i < N; i++)
+        routes[i] = "/api/v2/service-" + std::to_string(gen() % 1000) + "/resource/" + std::to_string(i);
+    std::string buffer;
+    std::vector<size_t> offsets;
+    for (int i = 0; i < LOOKUPS; i++) {
+        offsets.push_back(buffer.size());
+        buffer += routes[gen() % N];
+    }
+    offsets.push_back(buffer.size());
+    std::vector<std::string_view> requests;
+    for (int i = 0; i < LOOKUPS; i++)
+        requests.push_back(std::string_view(buffer).substr(offsets[i], offsets[i + 1] - offsets[i]));
+
+    sjtu::map<std::string, int> plain;
+    sjtu::map<std::string, int, std::less<>> transparent;
+    for (int i = 0; i < N; i++)
+        plain[routes[i]] = transparent[routes[i]] = i;
+    bench::measure("sjtu::map<string, int, less<string>> 1M lookups", [&] { route(plain, requests); });
+    bench::measure("sjtu::map<string, int, less<>>       1M lookups", [&] { route(transparent, requests); });
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "map.hpp"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+long long allocated = 0, deallocated = 0;
+
+template <class T> class CountingAllocator {
+public:
+	typedef T value_type;
+	int tag;
+
+	CountingAllocator(int tag = 0) : tag(tag) {}
+	template <class U> CountingAllocator(const CountingAllocator<U> &other) : tag(other.tag) {}
+
+	T *allocate(size_t n) {
+		allocated += n * sizeof(T);
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T *p, size_t n) {
+		deallocated += n * sizeof(T);
+		::operator delete(p);
+	}
+	template <class U> bool operator==(const CountingAllocator<U> &other) const { return tag == other.tag; }
+	template <class U> bool operator!=(const CountingAllocator<U> &other) const { return tag != other.tag; }
+};
+
+typedef sjtu::map<int, std::string, std::less<int>, CountingAllocator<sjtu::pair<const int, std::string>>> Map;
+
+void tester() {
+	Map map(CountingAllocator<sjtu::pair<const int, std::string>>(7));
+	std::cout << map.get_allocator().tag << std::endl;
+	for (int i = 0; i < 10000; i++)
+		map[i * 7 % 10007] = std::to_string(i);
+	std::cout << map.size() << " " << (allocated > 0) << " " << (allocated > deallocated) << std::endl;
+	{
+		Map copy(map);
+		std::cout << copy.size() << " " << copy.get_allocator().tag << std::endl;
+		for (int i = 0; i < 10000; i += 2)
+			copy.erase(copy.find(i * 7 % 10007));
+		Map other;
+		other = copy;
+		std::cout << other.size() << " " << other.at(7) << std::endl;
+	}
+	for (int i = 0; i < 10000; i += 3)
+		map.erase(map.find(i * 7 % 10007));
+	// The freed nodes should be recycled
+	long long before = allocated;
+	for (int i = 0; i < 10000; i += 3)
+		map[i * 7 % 10007] = std::to_string(i);
+	std::cout << map.size() << " " << (allocated == before) << std::endl;
+	map.clear();
+	std::cout << map.size() << " " << (allocated == deallocated) << std::endl;
+	for (int i = 0; i < 100; i++)
+		map[i] = std::to_string(i);
+}
+
+int main() {
+	tester();
+	std::cout << (allocated == deallocated) << std::endl;
+	return 0;
+}
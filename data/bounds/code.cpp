@@ -0,0 +1,107 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Checks the cached bounds against the ones found by walking down from the root, and against the reference
+template <class Map> bool check(Map &map, const std::set<int> &ref) {
+	auto u = map.rt, v = map.rt;
+	while (u != nullptr && u->left != nullptr)
+		u = u->left;
+	while (v != nullptr && v->right != nullptr)
+		v = v->right;
+	if (map.first() != u || map.last() != v || map.size() != ref.size())
+		return false;
+	if (ref.empty())
+		return map.begin() == map.end() && map.cbegin() == map.cend();
+	return map.begin()->first == *ref.begin() && (--map.end())->first == *ref.rbegin() &&
+	       map.cbegin()->first == *ref.begin() && (--map.cend())->first == *ref.rbegin();
+}
+
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::set<int> ref;
+	bool ok = true;
+	for (int i = 0; i < 30000 && ok; i++) {
+		int key = rnd() % 2000, op = rnd() % 16;
+		if (op < 3) {
+			map[key] = key;
+			ref.insert(key);
+		} else if (op == 3) {
+			map.emplace(key, key);
+			ref.insert(key);
+		} else if (op == 4) {
+			// Hints at both ends, which is where the bounds change
+			map.insert(rnd() % 2 ? map.begin() : map.end(), sjtu::pair<const int, int>(key, key));
+			ref.insert(key);
+		} else if (op == 5) {
+			map.insert(sjtu::pair<const int, int>(key, key));
+			ref.insert(key);
+		} else if (op <= 7) {
+			map.erase(key);
+			ref.erase(key);
+		} else if (op == 8 && !ref.empty()) {
+			// Pop the minimum or the maximum, as a queue does
+			if (rnd() % 2) {
+				ref.erase(map.begin()->first);
+				map.erase(map.begin());
+			} else {
+				ref.erase((--map.end())->first);
+				map.erase(--map.end());
+			}
+		} else if (op == 9) {
+			Map upper = map.split(key);
+			if (rnd() % 2)
+				map.join(upper);
+			else
+				upper.join(map), map = std::move(upper);
+		} else if (op == 10 && rnd() % 8 == 0) {
+			int hi = key + rnd() % 200;
+			map.erase_range(key, hi);
+			ref.erase(ref.lower_bound(key), ref.lower_bound(hi));
+		} else if (op == 11 && !ref.empty()) {
+			auto handle = map.extract(rnd() % 2 ? map.begin() : --map.end());
+			Map other;
+			other.insert(std::move(handle));
+			map.merge(other);
+		} else if (op == 12 && rnd() % 16 == 0) {
+			Map copy(map);
+			map.clear();
+			ok &= check(map, std::set<int>());
+			map = copy;
+		} else if (op == 13 && rnd() % 16 == 0) {
+			std::vector<sjtu::pair<const int, int>> items;
+			for (auto it = map.cbegin(); it != map.cend(); ++it)
+				items.push_back(*it);
+			Map built(items.begin(), items.end());
+			map = std::move(built);
+		} else if (op == 14) {
+			Map other;
+			other[key] = key;
+			ref.insert(key);
+			map.merge(other);
+		}
+		ok &= check(map, ref);
+	}
+	std::cout << name << " " << map.size() << " " << ok << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+	tester<sjtu::pmr::map<int, int>>("pmr::map");
+
+	// Moving and swapping through moves carry the bounds along
+	sjtu::map<int, int> a, b;
+	for (int i = 0; i < 10; i++)
+		a[i] = i;
+	b = std::move(a);
+	sjtu::map<int, int> c(std::move(b));
+	std::cout << c.begin()->first << " " << (--c.end())->first << " " << (a.begin() == a.end()) << " "
+	          << (b.begin() == b.end()) << std::endl;
+	a[5] = 5;
+	std::cout << a.begin()->first << " " << (--a.end())->first << std::endl;
+	return 0;
+}
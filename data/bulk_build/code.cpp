@@ -0,0 +1,69 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key * 3; }
+
+typedef sjtu::pair<int, int> Pair;
+
+template <class Map> void tester(const char *name) {
+	bool ok = true;
+	for (int n = 0; n <= 300; n++) {
+		std::vector<int> keys;
+		std::vector<Pair> input;
+		for (int i = 0; i < n; i++)
+			keys.push_back(i * 2), input.push_back(Pair(i * 2, i * 6));
+		Map map(input.begin(), input.end());
+		ok &= check(map, keys, value_of);
+		// The tree is still usable afterwards
+		map[-1] = -3;
+		map.erase(map.find(-1));
+		if (n > 0)
+			map.erase(map.find(keys[n / 2])), keys.erase(keys.begin() + n / 2);
+		ok &= check(map, keys, value_of);
+	}
+	std::cout << name << " " << ok << std::endl;
+
+	// Duplicate keys keep the first one
+	std::vector<Pair> dup = {Pair(1, 3), Pair(1, 100), Pair(2, 6), Pair(2, 7), Pair(2, 8), Pair(5, 15)};
+	Map map;
+	map[100] = 300;
+	map.assign_sorted(dup.begin(), dup.end());
+	std::cout << check(map, {1, 2, 5}, value_of) << " " << map.size() << std::endl;
+
+	// Unsorted input is still accepted
+	std::list<Pair> unsorted;
+	std::vector<int> keys;
+	for (int i = 0; i < 1000; i++) {
+		int key = rnd() % 5000;
+		unsorted.push_back(Pair(key, key * 3));
+		keys.push_back(key);
+	}
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	map.assign_sorted(unsorted.begin(), unsorted.end());
+	std::cout << check(map, keys, value_of) << " " << map.size() << std::endl;
+
+	// From the iterators of another map
+	Map copy(map.begin(), map.end());
+	std::cout << check(copy, keys, value_of) << std::endl;
+	copy.assign_sorted(map.begin(), map.begin());
+	std::cout << copy.size() << " " << copy.empty() << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+
+	std::vector<sjtu::pair<std::string, int>> words;
+	for (int i = 0; i < 26; i++)
+		words.push_back(sjtu::pair<std::string, int>(std::string(1, 'a' + i), i));
+	sjtu::map<std::string, int> map(words.begin(), words.end());
+	std::cout << map.size() << " " << map.begin()->first << " " << map.at("q") << std::endl;
+	return 0;
+}
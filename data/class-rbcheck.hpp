@@ -0,0 +1,66 @@
+#ifndef SJTU_CLASS_RBCHECK_HPP
+#define SJTU_CLASS_RBCHECK_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// The fixtures shared by the tests of the red-black tree behind sjtu::map
+
+// A xorshift generator, so that every run sees the same sequence of keys
+inline unsigned int seed = 19260817;
+inline unsigned int rnd() {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+// The number of calls to the comparators of the tests
+inline long long comparisons = 0;
+
+// A comparator of int keys counting its calls
+struct Less {
+	bool operator()(int a, int b) const {
+		comparisons++;
+		return a < b;
+	}
+};
+
+// Returns the black height of the subtree, or -1 if it is not a valid red-black tree.
+// The parent links, the colors, the black heights and the order of the keys under less are all checked.
+template <class Node, class Less = std::less<>> int validate(const Node *cur, const Node *parent, Less less = Less()) {
+	if (cur == nullptr)
+		return 0;
+	if (cur->parent != parent)
+		return -1;
+	if (parent != nullptr && parent->col == 1 && cur->col == 1)
+		return -1;
+	if (cur->left != nullptr && !less(cur->left->data.first, cur->data.first))
+		return -1;
+	if (cur->right != nullptr && !less(cur->data.first, cur->right->data.first))
+		return -1;
+	int lh = validate(cur->left, cur, less), rh = validate(cur->right, cur, less);
+	if (lh < 0 || lh != rh)
+		return -1;
+	return lh + (cur->col == 0);
+}
+
+// Checks that the map holds exactly the sorted keys, each mapped to value(key), in a valid red-black tree.
+// With order statistics, the rank queries are checked on every step-th key as well.
+template <class Map, class Value>
+bool check(const Map &map, const std::vector<int> &keys, Value value, size_t step = 1) {
+	if (map.size() != keys.size() || validate(map.rt, (decltype(map.rt)) nullptr) < 0)
+		return false;
+	size_t i = 0;
+	for (auto it = map.cbegin(); it != map.cend(); ++it, ++i)
+		if (i >= keys.size() || it->first != keys[i] || it->second != value(keys[i]))
+			return false;
+	if constexpr (Map::order_statistics)
+		for (size_t j = 0; j < keys.size(); j += step)
+			if (map.nth(j)->first != keys[j] || map.rank(keys[j]) != j)
+				return false;
+	return i == keys.size();
+}
+
+#endif
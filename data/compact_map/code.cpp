@@ -0,0 +1,186 @@
+#include "compact_map.hpp"
+#include "class-rbcheck.hpp"
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <string>
+
+class Integer {
+public:
+	static int counter;
+	int val;
+
+	Integer(int val) : val(val) {
+		counter++;
+	}
+
+	Integer(const Integer &rhs) {
+		val = rhs.val;
+		counter++;
+	}
+
+	Integer &operator=(const Integer &rhs) {
+		assert(false);
+	}
+
+	~Integer() {
+		counter--;
+	}
+};
+
+int Integer::counter = 0;
+
+class Compare {
+public:
+	bool operator()(const Integer &lhs, const Integer &rhs) const {
+		return lhs.val < rhs.val;
+	}
+};
+
+template <class Map, class Ref> bool same(const Map &map, const Ref &ref) {
+	if (map.size() != ref.size())
+		return false;
+	auto it = map.cbegin();
+	for (auto &kv : ref) {
+		if (it == map.cend() || it->first.val != kv.first || it->second != kv.second)
+			return false;
+		++it;
+	}
+	return it == map.cend();
+}
+
+void tester() {
+	sjtu::compact_map<Integer, std::string, Compare> map;
+	std::map<int, std::string> ref;
+	// Iterators refer to nodes by index, which should survive the growth of the array
+	map[Integer(-1)] = "first";
+	auto first = map.find(Integer(-1));
+	for (int i = 0; i < 100000; i++) {
+		int key = rnd() % 20000, opt = rnd() % 3;
+		if (opt == 0) {
+			auto res = map.insert(sjtu::pair<Integer, std::string>(Integer(key), std::to_string(i)));
+			auto ref_res = ref.insert({key, std::to_string(i)});
+			assert(res.second == ref_res.second && res.first->second == ref_res.first->second);
+		} else if (opt == 1) {
+			map[Integer(key)] = std::to_string(i);
+			ref[key] = std::to_string(i);
+		} else if (map.count(Integer(key))) {
+			map.erase(map.find(Integer(key)));
+			ref.erase(key);
+		}
+	}
+	ref[-1] = "first";
+	std::cout << first->first.val << " " << first->second << std::endl;
+	std::cout << map.size() << " " << same(map, ref) << std::endl;
+
+	sjtu::compact_map<Integer, std::string, Compare> copy(map);
+	for (int i = 0; i < 20000; i += 2)
+		if (copy.count(Integer(i)))
+			copy.erase(copy.find(Integer(i)));
+	std::cout << copy.size() << " " << map.size() << " " << same(map, ref) << std::endl;
+	copy = map;
+	std::cout << copy.size() << " " << same(copy, ref) << std::endl;
+
+	// Walk backward from the end
+	auto it = map.end();
+	auto ref_it = ref.end();
+	bool backward = true;
+	while (ref_it != ref.begin()) {
+		--it;
+		--ref_it;
+		backward &= it->first.val == ref_it->first;
+	}
+	std::cout << backward << " " << (it == map.begin()) << std::endl;
+	try {
+		--it;
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	try {
+		map.at(Integer(100000));
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+
+	while (!map.empty())
+		map.erase(map.begin());
+	std::cout << map.size() << " " << (map.begin() == map.end()) << std::endl;
+	map.clear();
+	copy.clear();
+}
+
+// A comparator with state, ordering integers by their remainder first
+struct ByRemainder {
+	int mod;
+	explicit ByRemainder(int mod) : mod(mod) {}
+	bool operator()(int lhs, int rhs) const {
+		return lhs % mod != rhs % mod ? lhs % mod < rhs % mod : lhs < rhs;
+	}
+};
+
+// A strcmp-like comparator, counting its calls
+struct ThreeWay {
+	using is_three_way = void;
+	int operator()(int lhs, int rhs) const {
+		comparisons++;
+		return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+	}
+};
+
+void comparators() {
+	sjtu::compact_map<int, int, ByRemainder> by_remainder(ByRemainder(3));
+	for (int i = 0; i < 10; i++)
+		by_remainder[i] = i;
+	sjtu::compact_map<int, int, ByRemainder> copy(by_remainder);
+	copy[10] = 10;
+	for (auto it = copy.cbegin(); it != copy.cend(); ++it)
+		std::cout << it->first << " ";
+	std::cout << by_remainder.size() << " " << copy.count(7) << std::endl;
+
+	sjtu::compact_map<int, int, ThreeWay> three_way;
+	for (int i = 0; i < 1000; i++)
+		three_way[i * 7 % 1000] = i;
+	comparisons = 0;
+	bool found = three_way.find(500) != three_way.end() && three_way.find(1000) == three_way.end();
+	// A single comparison on each of at most 2 log(n) levels
+	std::cout << three_way.size() << " " << found << " " << (comparisons <= 40) << std::endl;
+}
+
+// A key whose compare() member is an equality test, which must not be taken as a three-way result
+struct Tag {
+	int id;
+	Tag(int x) : id(x) {}
+	bool compare(const Tag &other) const { return id == other.id; }
+	bool operator<(const Tag &other) const { return id < other.id; }
+};
+
+void equality_compare() {
+	sjtu::compact_map<Tag, int> tags;
+	for (int i = 0; i < 10; i++)
+		tags[Tag((i * 7) % 10)] = i;
+	std::cout << tags.size() << " ";
+	for (auto it = tags.cbegin(); it != tags.cend(); ++it)
+		std::cout << it->first.id;
+	std::cout << " " << tags.count(Tag(3)) << " " << tags.count(Tag(10)) << std::endl;
+}
+
+// The elements move when the array grows, so only the iterators survive an insertion
+void reallocation() {
+	sjtu::compact_map<int, std::string> map;
+	for (int i = 0; i < 31; i++)
+		map[i] = std::to_string(i);
+	auto it = map.find(0);
+	const std::string *before = &map[0];
+	map[100] = "x";
+	std::cout << (&it->second != before) << " " << it->second << " " << map.size() << std::endl;
+}
+
+int main() {
+	tester();
+	std::cout << Integer::counter << std::endl;
+	comparators();
+	reallocation();
+	equality_compare();
+	return 0;
+}
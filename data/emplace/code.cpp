@@ -0,0 +1,86 @@
+#include "map.hpp"
+#include <iostream>
+#include <string>
+
+// Counts how many times the values are constructed, copied and assigned
+struct Counter {
+	static int constructed, copied, assigned;
+	int value;
+	Counter() : value(0) { constructed++; }
+	Counter(int _value, int scale = 1) : value(_value * scale) { constructed++; }
+	Counter(const Counter &other) : value(other.value) { copied++; }
+	Counter &operator=(const Counter &other) {
+		value = other.value;
+		assigned++;
+		return *this;
+	}
+	static void reset() { constructed = copied = assigned = 0; }
+	static void report(const char *name) {
+		std::cout << name << ": constructed " << constructed << ", copied " << copied << ", assigned " << assigned
+		          << std::endl;
+		reset();
+	}
+};
+int Counter::constructed = 0, Counter::copied = 0, Counter::assigned = 0;
+
+template <class Map> void tester(const char *name) {
+	std::cout << name << std::endl;
+	Map map;
+	Counter::reset();
+
+	// operator[] constructs the value only on a miss
+	for (int i = 0; i < 100; i++)
+		map[i].value = i;
+	Counter::report("operator[] miss");
+	int sum = 0;
+	for (int i = 0; i < 100; i++)
+		sum += map[i].value;
+	std::cout << sum << std::endl;
+	Counter::report("operator[] hit");
+
+	// try_emplace constructs in place from the arguments, and does nothing on a hit
+	for (int i = 100; i < 200; i++) {
+		auto res = map.try_emplace(i, i, 2);
+		if (!res.second || res.first->second.value != i * 2)
+			std::cout << "wrong" << std::endl;
+	}
+	Counter::report("try_emplace miss");
+	for (int i = 100; i < 200; i++)
+		if (map.try_emplace(i, -1).second)
+			std::cout << "wrong" << std::endl;
+	std::cout << map.at(150).value << std::endl;
+	Counter::report("try_emplace hit");
+
+	// insert_or_assign assigns on a hit
+	auto res = map.insert_or_assign(5, Counter(55));
+	std::cout << res.second << " " << res.first->second.value << std::endl;
+	auto added = map.insert_or_assign(500, Counter(500));
+	std::cout << added.second << " " << added.first->second.value << std::endl;
+	Counter::report("insert_or_assign");
+
+	// emplace constructs the element before the search
+	auto e = map.emplace(600, 6);
+	std::cout << e.second << " " << e.first->second.value << std::endl;
+	auto again = map.emplace(600, 7);
+	std::cout << again.second << " " << again.first->second.value << std::endl;
+	Counter::report("emplace");
+	auto hint = map.emplace_hint(map.end(), std::piecewise_construct, std::forward_as_tuple(700), std::forward_as_tuple(7, 10));
+	std::cout << hint->first << " " << hint->second.value << " " << map.size() << std::endl;
+	Counter::report("emplace_hint");
+}
+
+int main() {
+	tester<sjtu::map<int, Counter>>("map");
+	tester<sjtu::ranked_map<int, Counter>>("ranked_map");
+
+	sjtu::map<std::string, std::string> words;
+	words.try_emplace("a", 3, 'x');
+	words.insert_or_assign("b", "yy");
+	words.insert_or_assign("a", "z");
+	words.emplace("c", "w");
+	words["d"] += "v";
+	for (auto it = words.begin(); it != words.end(); ++it)
+		std::cout << it->first << "=" << it->second << " ";
+	std::cout << words.size() << std::endl;
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key * 2; }
+
+template <class Map> void tester(const char *name) {
+	bool ok = true;
+	for (int round = 0; round < 20; round++) {
+		Map map;
+		for (int i = 0; i < 3000; i++)
+			map[i] = i * 2;
+		// Keep an iterator to an element that survives, to see that it stays valid
+		auto kept = map.find(round % 3 == 0 ? 1500 : 1503);
+		int kept_key = kept->first;
+		std::vector<int> keys;
+		int mod = 2 + round % 4;
+		comparisons = 0;
+		for (auto it = map.begin(); it != map.end();) {
+			if (it->first % mod != kept_key % mod && rnd() % 4 != 0)
+				it = map.erase(it);
+			else
+				keys.push_back(it->first), ++it;
+		}
+		ok &= comparisons == 0;
+		ok &= kept->first == kept_key && kept->second == kept_key * 2;
+		ok &= check(map, keys, value_of);
+		// Erasing the last element returns end()
+		auto last = --map.end();
+		ok &= map.erase(last) == map.end();
+		keys.pop_back();
+		// A const_iterator works as well
+		typename Map::const_iterator first = map.cbegin();
+		auto next = map.erase(first);
+		keys.erase(keys.begin());
+		ok &= next == map.begin() && check(map, keys, value_of);
+	}
+	// Erase everything while iterating
+	Map map;
+	for (int i = 0; i < 1000; i++)
+		map[rnd() % 5000] = 0;
+	for (auto it = map.begin(); it != map.end();)
+		it = map.erase(it);
+	ok &= map.empty() && map.begin() == map.end();
+	std::cout << name << " " << ok << std::endl;
+
+	try {
+		map.erase(map.end());
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	Map other;
+	other[1] = 2;
+	try {
+		map.erase(other.begin());
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound " << other.size() << std::endl;
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int, Less>>("map");
+	tester<sjtu::ranked_map<int, int, Less>>("ranked_map");
+	tester<sjtu::pmr::map<int, int, Less>>("pmr::map");
+
+	sjtu::map<std::string, int> words;
+	for (int i = 0; i < 26; i++)
+		words[std::string(1, 'a' + i)] = i;
+	for (auto it = words.begin(); it != words.end();)
+		it = it->second % 5 ? words.erase(it) : ++it;
+	for (auto it = words.begin(); it != words.end(); ++it)
+		std::cout << it->first;
+	std::cout << std::endl;
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key + 1; }
+
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::vector<int> keys;
+	bool ok = true;
+	size_t erased = 0;
+	for (int round = 0; round < 200; round++) {
+		for (int i = 0; i < 100; i++) {
+			int key = rnd() % 20000;
+			map[key] = key + 1;
+			auto pos = std::lower_bound(keys.begin(), keys.end(), key);
+			if (pos == keys.end() || *pos != key)
+				keys.insert(pos, key);
+		}
+		int lo = rnd() % 21000 - 500, hi = lo + rnd() % 500;
+		auto first = std::lower_bound(keys.begin(), keys.end(), lo), last = std::lower_bound(keys.begin(), keys.end(), hi);
+		size_t count = round % 2 ? map.erase_range(lo, hi) : (size_t)(last - first);
+		if (round % 2 == 0) {
+			auto next = map.erase(map.lower_bound(lo), map.lower_bound(hi));
+			ok &= next == map.lower_bound(hi);
+		}
+		ok &= count == (size_t)(last - first);
+		erased += count;
+		keys.erase(first, last);
+		ok &= check(map, keys, value_of, 3);
+	}
+	std::cout << name << " " << map.size() << " " << erased << " " << ok << std::endl;
+
+	// Empty and reversed ranges erase nothing
+	std::cout << map.erase_range(100, 100) << " " << map.erase_range(200, 100) << " " << map.size() << std::endl;
+	auto it = map.find(keys[keys.size() / 2]);
+	std::cout << (map.erase(it, it) == it) << " " << map.size() << std::endl;
+
+	// Up to the end, and everything
+	size_t half = keys.size() / 2;
+	map.erase(map.find(keys[half]), map.end());
+	keys.resize(half);
+	std::cout << check(map, keys, value_of, 3) << " " << map.size() << std::endl;
+	std::cout << map.erase_range(-1, 20000) << " " << map.empty() << std::endl;
+	map[1] = 2;
+	std::cout << map.size() << " " << (map.erase(map.begin(), map.end()) == map.end()) << " " << map.empty() << std::endl;
+	try {
+		Map other;
+		map.erase(other.begin(), other.end());
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+
+	sjtu::map<std::string, int> words;
+	for (int i = 0; i < 26; i++)
+		words[std::string(1, 'a' + i)] = i;
+	std::cout << words.erase_range("f", "t") << " " << words.size() << " " << words.at("e") << " " << words.at("t")
+	          << std::endl;
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Looks up batches of every size, including the ones smaller and larger than the number of searches in flight
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::map<int, int> ref;
+	for (int i = 0; i < 30000; i++) {
+		int key = rnd() % 100000;
+		map[key] = i;
+		ref[key] = i;
+	}
+	bool ok = true;
+	for (int n = 0; n <= 100; n++) {
+		std::vector<int> keys(n);
+		for (int &key : keys)
+			key = rnd() % 100001;
+		std::vector<typename Map::iterator> out(n);
+		map.find_batch(keys.data(), n, out.data());
+		for (int i = 0; i < n; i++) {
+			auto expected = ref.find(keys[i]);
+			if (expected == ref.end())
+				ok &= out[i] == map.end();
+			else
+				ok &= out[i] != map.end() && out[i]->first == keys[i] && out[i]->second == expected->second;
+		}
+	}
+
+	// A large batch with repeated keys, through a const map; it compares as often as find()
+	std::vector<int> keys(5000);
+	for (int &key : keys)
+		key = rnd() % 2 ? ref.lower_bound(rnd() % 100000)->first : rnd() % 100000;
+	keys[1] = keys[0];
+	const Map &view = map;
+	std::vector<typename Map::const_iterator> out(keys.size());
+	comparisons = 0;
+	view.find_batch(keys.data(), keys.size(), out.data());
+	long long batched = comparisons;
+	comparisons = 0;
+	for (size_t i = 0; i < keys.size(); i++)
+		ok &= out[i] == view.find(keys[i]);
+	std::cout << name << " " << ok << " " << (batched <= comparisons) << std::endl;
+
+	// The results can be used to modify the elements
+	std::vector<typename Map::iterator> found(keys.size());
+	map.find_batch(keys.data(), keys.size(), found.data());
+	long long sum = 0;
+	for (size_t i = 0; i < keys.size(); i++)
+		if (found[i] != map.end())
+			found[i]->second = -1;
+	for (auto it = map.cbegin(); it != map.cend(); ++it)
+		sum += it->second == -1;
+	std::set<int> probed(keys.begin(), keys.end());
+	long long expected = 0;
+	for (int key : probed)
+		expected += ref.count(key);
+	std::cout << (sum == expected) << std::endl;
+
+	Map empty;
+	std::vector<typename Map::iterator> none(3);
+	empty.find_batch(keys.data(), 3, none.data());
+	std::cout << (none[0] == empty.end() && none[1] == empty.end() && none[2] == empty.end()) << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int, Less>>("map");
+	tester<sjtu::ranked_map<int, int, Less>>("ranked_map");
+	tester<sjtu::threaded_map<int, int, Less>>("threaded_map");
+
+	sjtu::map<std::string, int> words;
+	words["apple"] = 1, words["banana"] = 2, words["cherry"] = 3;
+	std::string probes[] = {"cherry", "date", "apple", "apple", "aardvark"};
+	sjtu::map<std::string, int>::iterator out[5];
+	words.find_batch(probes, 5, out);
+	for (int i = 0; i < 5; i++)
+		std::cout << probes[i] << ":" << (out[i] == words.end() ? 0 : out[i]->second) << " ";
+	std::cout << std::endl;
+	return 0;
+}
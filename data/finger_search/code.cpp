@@ -0,0 +1,93 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+
+// Searches from random fingers and from the last result, against std::set
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::set<int> ref;
+	for (int i = 0; i < 20000; i++) {
+		int key = rnd() % 100000;
+		map[key] = key;
+		ref.insert(key);
+	}
+	bool ok = true;
+	for (int i = 0; i < 20000; i++) {
+		int key = rnd() % 100001, pos = rnd() % 100000;
+		auto finger = rnd() % 8 == 0 ? map.end() : map.lower_bound(pos);
+		auto expected = ref.lower_bound(key);
+		auto found = map.lower_bound(finger, key);
+		if (expected == ref.end())
+			ok &= found == map.end();
+		else
+			ok &= found != map.end() && found->first == *expected;
+		auto exact = map.find(finger, key);
+		ok &= ref.count(key) ? exact != map.end() && exact->first == key : exact == map.end();
+	}
+
+	// A walk over close keys, each search starting from the last result
+	long long local = 0, global = 0;
+	auto finger = map.cbegin();
+	for (int i = 0, key = 50000; i < 20000; i++) {
+		key += (int)(rnd() % 65) - 32;
+		comparisons = 0;
+		auto found = map.lower_bound(finger, key);
+		local += comparisons;
+		comparisons = 0;
+		ok &= found == map.lower_bound(key);
+		global += comparisons;
+		if (found != map.end())
+			finger = found;
+	}
+	std::cout << name << " " << ok << " " << (local < global) << std::endl;
+
+	// From every element to every key of a small map
+	Map small;
+	for (int i = 0; i < 20; i += 2)
+		small[i] = i;
+	ok = true;
+	for (auto from = small.cbegin(); from != small.cend(); ++from)
+		for (int key = -1; key <= 20; key++) {
+			auto found = small.lower_bound(from, key);
+			ok &= found == small.lower_bound(key);
+			ok &= small.find(from, key) == small.find(key);
+		}
+	std::cout << ok << std::endl;
+
+	Map empty;
+	std::cout << (empty.find(empty.end(), 1) == empty.end()) << " " << (empty.lower_bound(empty.cend(), 1) == empty.cend())
+	          << std::endl;
+	try {
+		map.find(small.begin(), 1);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int, Less>>("map");
+	tester<sjtu::ranked_map<int, int, Less>>("ranked_map");
+	tester<sjtu::threaded_map<int, int, Less>>("threaded_map");
+
+	// Looking words up in order, each from the last one
+	sjtu::map<std::string, int> words;
+	const char *text[] = {"apple", "banana", "cherry", "date", "elderberry", "fig", "grape"};
+	for (int i = 0; i < 7; i++)
+		words[text[i]] = i;
+	const sjtu::map<std::string, int> &view = words;
+	auto finger = view.cbegin();
+	for (const char *word : {"banana", "blueberry", "date", "grape", "apple"}) {
+		auto found = view.find(finger, word);
+		if (found == view.cend()) {
+			std::cout << word << ":none ";
+		} else {
+			std::cout << found->first << ":" << found->second << " ";
+			finger = found;
+		}
+	}
+	std::cout << std::endl;
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key + 1; }
+
+template <class Map> void tester(const char *name) {
+	typedef sjtu::pair<const int, int> Pair;
+	bool ok = true;
+
+	// Increasing keys at the end
+	Map map;
+	std::vector<int> keys;
+	comparisons = 0;
+	for (int i = 0; i < 10000; i++) {
+		auto it = map.insert(map.cend(), Pair(i * 2, i * 2 + 1));
+		ok &= it->first == i * 2;
+		keys.push_back(i * 2);
+	}
+	bool few = comparisons <= 10000;
+	std::cout << name << " " << check(map, keys, value_of, 5) << " " << few << std::endl;
+
+	// Decreasing keys before the first one
+	Map down;
+	std::vector<int> down_keys;
+	auto pos = down.end();
+	comparisons = 0;
+	for (int i = 10000; i > 0; i--) {
+		pos = down.insert(pos, Pair(i, i + 1));
+		down_keys.push_back(i);
+	}
+	few = comparisons <= 30000;
+	std::reverse(down_keys.begin(), down_keys.end());
+	std::cout << check(down, down_keys, value_of, 5) << " " << few << std::endl;
+
+	// Filling the gaps right after the hint
+	comparisons = 0;
+	for (int i = 0; i < 10000; i++) {
+		auto hint = map.find(i * 2);
+		long long before = comparisons;
+		auto it = map.emplace_hint(hint, i * 2 + 1, i * 2 + 2);
+		ok &= it->first == i * 2 + 1 && comparisons - before <= 3;
+	}
+	keys.clear();
+	for (int i = 0; i < 20000; i++)
+		keys.push_back(i);
+	std::cout << check(map, keys, value_of, 5) << " " << ok << std::endl;
+
+	// Existing keys and wrong hints
+	auto it = map.insert(map.find(100), Pair(100, 0));
+	std::cout << it->first << " " << it->second << " " << map.size() << std::endl;
+	for (int i = 0; i < 5000; i++) {
+		int key = 20000 + rnd() % 10000;
+		auto hint = map.find(rnd() % 20000);
+		it = map.insert(hint, Pair(key, key + 1));
+		ok &= it->first == key;
+		auto at = std::lower_bound(keys.begin(), keys.end(), key);
+		if (at == keys.end() || *at != key)
+			keys.insert(at, key);
+		if (i % 3 == 0) {
+			int erased = keys[rnd() % keys.size()];
+			map.erase(map.find(erased));
+			keys.erase(std::lower_bound(keys.begin(), keys.end(), erased));
+		}
+	}
+	std::cout << check(map, keys, value_of, 5) << " " << ok << std::endl;
+	try {
+		Map other;
+		map.insert(other.cend(), Pair(1, 2));
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int, Less>>("map");
+	tester<sjtu::ranked_map<int, int, Less>>("ranked_map");
+
+	sjtu::map<std::string, int> words;
+	for (int i = 0; i < 26; i++)
+		words.emplace_hint(words.end(), std::string(1, 'a' + i), i);
+	std::cout << words.size() << " " << words.begin()->first << " " << (--words.end())->first << std::endl;
+	return 0;
+}
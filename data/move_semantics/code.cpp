@@ -0,0 +1,107 @@
+#include "map.hpp"
+#include <iostream>
+#include <memory_resource>
+#include <string>
+
+// Counts how many times the objects are copied and moved
+struct Tracked {
+	static int copied, moved;
+	int value;
+	Tracked(int _value = 0) : value(_value) {}
+	Tracked(const Tracked &other) : value(other.value) { copied++; }
+	Tracked(Tracked &&other) noexcept : value(other.value) {
+		other.value = -1;
+		moved++;
+	}
+	Tracked &operator=(const Tracked &other) {
+		value = other.value;
+		copied++;
+		return *this;
+	}
+	Tracked &operator=(Tracked &&other) noexcept {
+		value = other.value;
+		other.value = -1;
+		moved++;
+		return *this;
+	}
+	bool operator<(const Tracked &other) const { return value < other.value; }
+	static void report(const char *name) {
+		std::cout << name << ": copied " << copied << ", moved " << moved << std::endl;
+		copied = moved = 0;
+	}
+};
+int Tracked::copied = 0, Tracked::moved = 0;
+
+typedef sjtu::map<Tracked, Tracked> Map;
+
+Map make(int n) {
+	Map res;
+	for (int i = 0; i < n; i++)
+		res.try_emplace(Tracked(i), i * 2);
+	return res;
+}
+
+int main() {
+	// Returning and moving maps doesn't touch the elements
+	Map map = make(1000);
+	Tracked::report("make");
+	auto it = map.find(Tracked(500));
+	Map moved(std::move(map));
+	std::cout << moved.size() << " " << map.size() << " " << (moved.find(Tracked(500))->second.value == it->second.value)
+	          << " " << (&moved.find(Tracked(500))->second == &it->second) << std::endl;
+	Tracked::report("move construct");
+	map = make(10);
+	Tracked::report("make and move assign");
+	std::cout << map.size() << std::endl;
+	map = std::move(moved);
+	std::cout << map.size() << " " << moved.size() << std::endl;
+	Tracked::report("move assign");
+	moved[Tracked(1)] = Tracked(2);
+	std::cout << moved.size() << " " << moved.at(Tracked(1)).value << std::endl;
+	Tracked::report("reuse");
+
+	// Inserting rvalues moves them into the nodes, except the const key of a value_type, which can only be copied
+	Map target;
+	target.insert(sjtu::pair<const Tracked, Tracked>(Tracked(1), Tracked(10)));
+	Tracked::report("insert(value_type &&)");
+	target.insert(target.cend(), sjtu::pair<const Tracked, Tracked>(Tracked(2), Tracked(20)));
+	Tracked::report("insert(hint, value_type &&)");
+	target.insert(sjtu::pair<Tracked, Tracked>(Tracked(5), Tracked(50)));
+	Tracked::report("insert(pair<Key, T> &&)");
+	sjtu::pair<Tracked, Tracked> hinted(Tracked(6), Tracked(60));
+	target.insert(target.cend(), std::move(hinted));
+	std::cout << hinted.first.value << " " << hinted.second.value << std::endl;
+	Tracked::report("insert(hint, pair<Key, T> &&)");
+	Tracked key(3), value(30);
+	target.try_emplace(std::move(key), std::move(value));
+	std::cout << key.value << " " << value.value << std::endl;
+	Tracked::report("try_emplace(Key &&)");
+	Tracked again(3);
+	target.try_emplace(std::move(again), 0);
+	std::cout << again.value << std::endl;
+	Tracked::report("try_emplace(Key &&) on a hit");
+	target[Tracked(4)] = Tracked(40);
+	Tracked::report("operator[](Key &&)");
+	target.insert_or_assign(Tracked(4), Tracked(41));
+	Tracked::report("insert_or_assign(Key &&)");
+	for (auto i = target.cbegin(); i != target.cend(); ++i)
+		std::cout << i->first.value << "=" << i->second.value << " ";
+	std::cout << std::endl;
+
+	// Maps on different memory resources move the elements one by one
+	std::pmr::monotonic_buffer_resource first, second;
+	sjtu::pmr::map<int, std::string> a(&first), b(&second), c(&first);
+	for (int i = 0; i < 100; i++)
+		a[i] = std::string(20, 'a' + i % 26);
+	b = std::move(a);
+	std::cout << b.size() << " " << a.size() << " " << b.at(27) << std::endl;
+	c = std::move(b);
+	std::cout << c.size() << " " << b.size() << " " << c.at(28) << std::endl;
+
+	// Strings
+	sjtu::map<std::string, std::string> words;
+	std::string word(30, 'w');
+	words[std::move(word)] = "x";
+	std::cout << words.size() << " " << words.begin()->first.size() << std::endl;
+	return 0;
+}
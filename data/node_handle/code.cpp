@@ -0,0 +1,218 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key * 2; }
+
+// A memory resource counting the bytes it holds
+class counting_resource : public std::pmr::memory_resource {
+  public:
+	long long held = 0;
+
+  private:
+	void *do_allocate(size_t bytes, size_t align) override {
+		held += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, align);
+	}
+	void do_deallocate(void *ptr, size_t bytes, size_t align) override {
+		held -= bytes;
+		std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+	}
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+// An allocator drawing from an arena, which can't be default constructed
+template <class T> class Arena {
+  public:
+	typedef T value_type;
+	int *live;
+
+	explicit Arena(int *live) : live(live) {}
+	template <class U> Arena(const Arena<U> &other) : live(other.live) {}
+
+	T *allocate(size_t n) {
+		++*live;
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T *p, size_t) {
+		--*live;
+		::operator delete(p);
+	}
+	template <class U> bool operator==(const Arena<U> &other) const { return live == other.live; }
+	template <class U> bool operator!=(const Arena<U> &other) const { return live != other.live; }
+};
+
+template <class Map> void tester(const char *name) {
+	bool ok = true;
+	Map staging, live;
+	std::vector<int> staging_keys, live_keys;
+	for (int i = 0; i < 2000; i++) {
+		int key = rnd() % 10000;
+		if (i % 2) {
+			if (staging.insert({key, key * 2}).second)
+				staging_keys.push_back(key);
+		} else if (live.insert({key, key * 2}).second) {
+			live_keys.push_back(key);
+		}
+	}
+	std::sort(staging_keys.begin(), staging_keys.end());
+	std::sort(live_keys.begin(), live_keys.end());
+
+	// Promote single nodes, whose addresses stay the same
+	for (int i = 0; i < 300; i++) {
+		int key = staging_keys[rnd() % staging_keys.size()];
+		const int *address = &staging.find(key)->second;
+		auto node = i % 2 ? staging.extract(key) : staging.extract(staging.find(key));
+		ok &= !node.empty() && node.key() == key && node.mapped() == key * 2;
+		staging_keys.erase(std::lower_bound(staging_keys.begin(), staging_keys.end(), key));
+		auto res = live.insert(std::move(node));
+		auto pos = std::lower_bound(live_keys.begin(), live_keys.end(), key);
+		if (pos != live_keys.end() && *pos == key) {
+			// The key exists, so the node is given back
+			ok &= !res.inserted && res.node && res.node.key() == key && res.position->first == key;
+		} else {
+			live_keys.insert(pos, key);
+			ok &= res.inserted && res.node.empty() && &res.position->second == address && node.empty();
+		}
+	}
+	ok &= check(staging, staging_keys, value_of) && check(live, live_keys, value_of);
+	std::cout << name << " " << staging.size() << " " << live.size() << " " << ok << std::endl;
+
+	// A missing key gives an empty node, and inserting it does nothing
+	auto empty = staging.extract(-1);
+	std::cout << empty.empty() << " " << (bool)empty << std::endl;
+	auto res = live.insert(std::move(empty));
+	std::cout << res.inserted << " " << (res.position == live.end()) << " " << live.size() << std::endl;
+
+	// The key can be changed, and the node can outlive its map
+	Map *temp = new Map;
+	(*temp)[5] = 10;
+	auto node = temp->extract(5);
+	delete temp;
+	node.key() = 20001;
+	node.mapped() = 40002;
+	live.insert(std::move(node));
+	live_keys.push_back(20001);
+	std::cout << check(live, live_keys, value_of) << std::endl;
+
+	// Merge moves the keys that don't conflict
+	std::vector<int> merged, left;
+	std::set_union(live_keys.begin(), live_keys.end(), staging_keys.begin(), staging_keys.end(),
+	               std::back_inserter(merged));
+	std::set_intersection(staging_keys.begin(), staging_keys.end(), live_keys.begin(), live_keys.end(),
+	                      std::back_inserter(left));
+	live.merge(staging);
+	std::cout << check(live, merged, value_of) << " " << check(staging, left, value_of) << " " << live.size() << " " << staging.size()
+	          << std::endl;
+	live.merge(live);
+	std::cout << check(live, merged, value_of) << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+	tester<sjtu::pmr::map<int, int>>("pmr::map");
+
+	// Maps on different memory resources move the elements instead
+	std::pmr::monotonic_buffer_resource first, second;
+	sjtu::pmr::map<int, int> a(&first), b(&second);
+	for (int i = 0; i < 100; i++)
+		a[i] = i * 2, b[i + 50] = (i + 50) * 2;
+	auto node = a.extract(0);
+	b.insert(std::move(node));
+	b.merge(a);
+	std::vector<int> keys;
+	for (int i = 0; i < 150; i++)
+		keys.push_back(i);
+	std::cout << check(b, keys, value_of) << " " << a.size() << std::endl;
+
+	// A handle assigned a node takes the allocator of that node, so it isn't mixed up with the default resource
+	counting_resource fallback, request;
+	std::pmr::memory_resource *previous = std::pmr::set_default_resource(&fallback);
+	{
+		sjtu::pmr::map<int, int> source(&request), target;
+		for (int i = 0; i < 100; i++)
+			source[i] = i * 2;
+		sjtu::pmr::map<int, int>::node_type handle;
+		handle = source.extract(3);
+		std::cout << (handle.get_allocator().resource() == &request) << " ";
+		target.insert(std::move(handle));
+		std::cout << handle.empty() << " " << target.size() << " " << source.size() << std::endl;
+	}
+	std::pmr::set_default_resource(previous);
+	std::cout << fallback.held << " " << request.held << std::endl;
+
+	// The source of a merge returns its chunks when cleared, unless they hold the moved nodes
+	counting_resource memory;
+	{
+		sjtu::pmr::map<int, int> live(&memory), staging(&memory);
+		for (int i = 0; i < 1000; i++)
+			live[i] = i * 2;
+		long long before = memory.held;
+		for (int i = 0; i < 1000; i += 2)
+			staging[i] = i * 2;
+		live.merge(staging);
+		staging.clear();
+		std::cout << (memory.held == before) << " ";
+		for (int i = 500; i < 1500; i++)
+			staging[i] = i * 2;
+		live.merge(staging);
+		staging.clear();
+		long long after = memory.held;
+		for (int i = 0; i < 3000; i++)
+			staging[i + 5000] = i;
+		staging.clear();
+		std::cout << (memory.held == after) << " " << live.size() << " ";
+		live.clear();
+		std::cout << memory.held << std::endl;
+	}
+
+	// A dropped handle gives its node back to the map it was extracted from, so the memory stays flat
+	{
+		sjtu::pmr::map<int, int> fixed(&memory);
+		for (int i = 0; i < 1000; i++)
+			fixed[i] = i * 2;
+		long long before = memory.held;
+		bool flat = true;
+		for (int i = 0; i < 100000; i++) {
+			int key = rnd() % 1000;
+			fixed.extract(key);
+			fixed[key] = key * 2;
+			flat &= memory.held == before;
+		}
+		std::cout << flat << " " << fixed.size() << std::endl;
+	}
+
+	// Node handles work with an allocator which has no default constructor
+	int chunks = 0;
+	{
+		typedef sjtu::map<int, int, std::less<int>, Arena<sjtu::pair<const int, int>>> ArenaMap;
+		Arena<sjtu::pair<const int, int>> arena(&chunks);
+		ArenaMap from(arena), to(arena);
+		for (int i = 0; i < 100; i++)
+			from[i] = i * 2;
+		ArenaMap::node_type handle = from.extract(from.begin());
+		std::cout << (handle.get_allocator().live == &chunks) << " ";
+		auto res = to.insert(std::move(handle));
+		std::cout << res.inserted << " " << handle.empty() << " " << from.extract(1000).empty() << " ";
+		to.merge(from);
+		std::vector<int> keys;
+		for (int i = 0; i < 100; i++)
+			keys.push_back(i);
+		std::cout << check(to, keys, value_of) << " " << from.size() << std::endl;
+	}
+	std::cout << chunks << std::endl;
+
+	sjtu::map<std::string, std::string> words, more;
+	words["apple"] = "red";
+	more["banana"] = "yellow";
+	more["apple"] = "green";
+	words.merge(more);
+	std::cout << words.size() << " " << more.size() << " " << words["apple"] << " " << more["apple"] << std::endl;
+	return 0;
+}
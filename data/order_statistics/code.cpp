@@ -0,0 +1,88 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+typedef sjtu::ranked_map<int, int> Map;
+
+bool check(const Map &map, const std::vector<int> &keys) {
+	if (map.size() != keys.size())
+		return false;
+	for (size_t i = 0; i < keys.size(); i += 7) {
+		auto it = map.nth(i);
+		if (it->first != keys[i] || map.rank(it) != i || map.rank(keys[i]) != i)
+			return false;
+	}
+	return map.nth(keys.size()) == map.cend() && map.rank(map.cend()) == keys.size();
+}
+
+void tester() {
+	Map map;
+	std::vector<int> keys;
+	bool ok = true;
+	for (int round = 0; round < 20; round++) {
+		for (int i = 0; i < 2000; i++) {
+			int key = rnd() % 10000;
+			auto pos = std::lower_bound(keys.begin(), keys.end(), key);
+			if (rnd() % 3) {
+				map[key] = i;
+				if (pos == keys.end() || *pos != key)
+					keys.insert(pos, key);
+			} else if (pos != keys.end() && *pos == key) {
+				map.erase(map.find(key));
+				keys.erase(pos);
+			}
+		}
+		ok &= check(map, keys);
+		Map copy(map);
+		ok &= check(copy, keys);
+	}
+	std::cout << map.size() << " " << ok << std::endl;
+
+	// Keys that are not in the map
+	std::cout << map.rank(-1) << " " << (map.rank(10000) == map.size()) << " " << map.rank(keys[5] + 1) << std::endl;
+
+	// Jump by advance() and measure by operator-
+	auto it = map.begin();
+	it.advance(100);
+	std::cout << it->first << " " << (it - map.begin()) << " " << (map.end() - it) << std::endl;
+	it.advance(-50);
+	std::cout << it->first << " " << (it - map.begin()) << std::endl;
+	auto jump = map.begin(), step = map.begin();
+	for (int i = 0; i < 300; i++)
+		++step;
+	jump.advance(300);
+	std::cout << (jump == step) << std::endl;
+	it = map.end();
+	it.advance(-1);
+	std::cout << (it->first == keys.back()) << std::endl;
+	try {
+		it.advance(2);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	try {
+		map.nth(map.size() + 1);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+
+	// Percentiles
+	for (int p = 0; p <= 100; p += 25) {
+		size_t k = (map.size() - 1) * p / 100;
+		std::cout << p << "% " << (map.nth(k)->first == keys[k]) << std::endl;
+	}
+
+	while (!map.empty())
+		map.erase(map.nth(map.size() / 2));
+	std::cout << map.size() << " " << map.rank(0) << std::endl;
+}
+
+int main() {
+	tester();
+	return 0;
+}
@@ -0,0 +1,87 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+
+// Uses the map as a double-ended priority queue, against std::set
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::set<int> ref;
+	bool ok = true, free = true;
+	long long sum = 0;
+	for (int i = 0; i < 50000; i++) {
+		int op = rnd() % 5;
+		if (op <= 1 || ref.empty()) {
+			int key = rnd() % 100000;
+			map[key] = key * 3;
+			ref.insert(key);
+		} else if (op == 2) {
+			ok &= map.front().first == *ref.begin() && map.front().second == *ref.begin() * 3;
+			sum += map.front().first;
+			comparisons = 0;
+			map.pop_front();
+			free &= comparisons == 0;
+			ref.erase(ref.begin());
+		} else if (op == 3) {
+			ok &= map.back().first == *ref.rbegin() && map.back().second == *ref.rbegin() * 3;
+			sum += map.back().first;
+			comparisons = 0;
+			map.pop_back();
+			free &= comparisons == 0;
+			ref.erase(--ref.end());
+		} else {
+			// front() and back() give references to the elements
+			map.front().second++, map.back().second--;
+			map.front().second--, map.back().second++;
+			const Map &view = map;
+			ok &= view.front().first == *ref.begin() && view.back().first == *ref.rbegin();
+		}
+		if (i % 5000 == 0)
+			ok &= validate(map.rt, (decltype(map.rt)) nullptr) >= 0;
+	}
+	while (!map.empty()) {
+		ok &= map.front().first == *ref.begin();
+		map.pop_front();
+		ref.erase(ref.begin());
+	}
+	ok &= ref.empty() && map.size() == 0 && map.begin() == map.end();
+	std::cout << name << " " << sum << " " << ok << " " << free << std::endl;
+
+	for (int i = 0; i < 4; i++) {
+		try {
+			if (i == 0)
+				map.front();
+			else if (i == 1)
+				map.back();
+			else if (i == 2)
+				map.pop_front();
+			else
+				map.pop_back();
+			std::cout << "no exception" << std::endl;
+		} catch (sjtu::exception &) {
+			std::cout << "container_is_empty" << std::endl;
+		}
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int, Less>>("map");
+	tester<sjtu::ranked_map<int, int, Less>>("ranked_map");
+	tester<sjtu::pmr::map<int, int, Less>>("pmr::map");
+
+	// Jobs scheduled by time, taken in order
+	sjtu::map<int, std::string> jobs;
+	jobs[30] = "backup";
+	jobs[10] = "email";
+	jobs[20] = "report";
+	jobs[40] = "cleanup";
+	std::cout << jobs.front().second << " " << jobs.back().second << std::endl;
+	jobs.pop_back();
+	while (!jobs.empty()) {
+		std::cout << jobs.front().first << ":" << jobs.front().second << " ";
+		jobs.pop_front();
+	}
+	std::cout << std::endl;
+	return 0;
+}
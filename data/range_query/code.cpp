@@ -0,0 +1,100 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <cassert>
+#include <iostream>
+#include <map>
+
+template <class Iter, class RefIter> bool same(Iter it, Iter end, RefIter ref_it, RefIter ref_end) {
+	if ((it == end) != (ref_it == ref_end))
+		return false;
+	return it == end || (it->first == ref_it->first && it->second == ref_it->second);
+}
+
+void test_bounds(sjtu::map<int, int> &map, std::map<int, int> &ref) {
+	const sjtu::map<int, int> &const_map = map;
+	bool ok = true;
+	for (int i = -10; i < 4010; i++) {
+		ok &= same(map.lower_bound(i), map.end(), ref.lower_bound(i), ref.end());
+		ok &= same(map.upper_bound(i), map.end(), ref.upper_bound(i), ref.end());
+		ok &= same(const_map.lower_bound(i), const_map.cend(), ref.lower_bound(i), ref.end());
+		ok &= same(const_map.upper_bound(i), const_map.cend(), ref.upper_bound(i), ref.end());
+		auto range = map.equal_range(i);
+		auto const_range = const_map.equal_range(i);
+		auto ref_range = ref.equal_range(i);
+		ok &= same(range.first, map.end(), ref_range.first, ref.end());
+		ok &= same(range.second, map.end(), ref_range.second, ref.end());
+		ok &= same(const_range.first, const_map.cend(), ref_range.first, ref.end());
+		ok &= same(const_range.second, const_map.cend(), ref_range.second, ref.end());
+		ok &= (range.first == range.second) == !ref.count(i);
+	}
+	std::cout << "bounds " << ok << std::endl;
+}
+
+void test_scan(sjtu::map<int, int> &map, std::map<int, int> &ref) {
+	bool ok = true;
+	for (int i = 0; i < 100; i++) {
+		int lo = rnd() % 4000, hi = lo + rnd() % 200;
+		long long sum = 0, ref_sum = 0;
+		for (auto it = map.lower_bound(lo); it != map.end() && it->first < hi; ++it)
+			sum += it->second;
+		for (auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi; ++it)
+			ref_sum += it->second;
+		ok &= sum == ref_sum;
+	}
+	std::cout << "scan " << ok << std::endl;
+}
+
+void test_count(sjtu::ranked_map<int, int> &map, std::map<int, int> &ref) {
+	bool ok = true;
+	for (int i = 0; i < 1000; i++) {
+		int lo = rnd() % 4200 - 100, hi = lo + rnd() % 1000 - 100;
+		size_t expected = lo < hi ? std::distance(ref.lower_bound(lo), ref.lower_bound(hi)) : 0;
+		ok &= map.count_range(lo, hi) == expected && map.range(lo, hi).size() == expected;
+		size_t visited = 0;
+		for (auto &kv : map.range(lo, hi)) {
+			ok &= lo <= kv.first && kv.first < hi && ref.at(kv.first) == kv.second;
+			visited++;
+		}
+		ok &= visited == expected;
+	}
+	std::cout << "count " << ok << std::endl;
+}
+
+void test_view() {
+	sjtu::map<int, int> map;
+	for (int i = 0; i < 10; i++)
+		map[i * 10] = i;
+	auto view = map.range(15, 45);
+	const auto const_view = static_cast<const sjtu::map<int, int> &>(map).range(15, 45);
+	// The view is evaluated lazily, so it sees the elements inserted later
+	map[16] = 100;
+	map.erase(map.find(40));
+	for (auto &kv : view) {
+		std::cout << kv.first << " ";
+		kv.second++;
+	}
+	std::cout << std::endl;
+	for (auto &kv : const_view)
+		std::cout << kv.second << " ";
+	std::cout << std::endl;
+	std::cout << map.range(45, 15).empty() << " " << map.range(100, 200).empty() << " " << map.range(0, 1).empty() << std::endl;
+}
+
+int main() {
+	sjtu::map<int, int> map;
+	std::map<int, int> ref;
+	for (int i = 0; i < 2000; i++) {
+		int key = rnd() % 4000;
+		map[key] = i;
+		ref[key] = i;
+	}
+	std::cout << map.size() << std::endl;
+	test_bounds(map, ref);
+	test_scan(map, ref);
+	sjtu::ranked_map<int, int> ranked;
+	for (auto &kv : ref)
+		ranked[kv.first] = kv.second;
+	test_count(ranked, ref);
+	test_view();
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static_assert(std::is_same<std::iterator_traits<sjtu::map<int, int>::iterator>::iterator_category,
+                           std::bidirectional_iterator_tag>::value,
+              "map iterators are bidirectional");
+static_assert(std::is_same<std::iterator_traits<sjtu::map<int, int>::const_reverse_iterator>::iterator_category,
+                           std::bidirectional_iterator_tag>::value,
+              "so are the reverse iterators");
+
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::vector<int> keys;
+	for (int i = 0; i < 3000; i++) {
+		int key = rnd() % 10000;
+		if (map.count(key) == 0)
+			keys.push_back(key);
+		map[key] = key * 2;
+	}
+	std::sort(keys.begin(), keys.end());
+	bool ok = true;
+
+	// Reverse iteration, with both kinds of reverse iterators
+	std::vector<int> seen;
+	for (auto it = map.rbegin(); it != map.rend(); ++it)
+		seen.push_back(it->first), it->second++;
+	ok &= std::equal(seen.begin(), seen.end(), keys.rbegin(), keys.rend());
+	seen.clear();
+	for (auto it = map.crbegin(); it != map.crend(); it++)
+		seen.push_back(it->second - 1);
+	std::vector<int> doubled;
+	for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+		doubled.push_back(*it * 2);
+	ok &= seen == doubled;
+
+	// Standard algorithms
+	ok &= std::prev(map.end())->first == keys.back() && std::next(map.begin(), 2)->first == keys[2];
+	ok &= std::prev(map.cend(), 3)->first == keys[keys.size() - 3];
+	auto odd = std::find_if(map.rbegin(), map.rend(), [](const auto &item) { return item.first % 2; });
+	ok &= odd->first == *std::find_if(keys.rbegin(), keys.rend(), [](int key) { return key % 2; });
+	ok &= std::count_if(map.cbegin(), map.cend(), [](const auto &item) { return item.first < 5000; }) ==
+	      std::lower_bound(keys.begin(), keys.end(), 5000) - keys.begin();
+	ok &= std::distance(map.cbegin(), map.cend()) == (std::ptrdiff_t)keys.size();
+	ok &= map.rbegin().base() == map.end() && map.rend().base() == map.begin();
+
+	// distance() found by argument-dependent lookup
+	for (int i = 0; i < 100; i++) {
+		int lo = rnd() % keys.size(), hi = lo + rnd() % (keys.size() - lo + 1);
+		auto first = map.find(keys[lo]), last = hi == (int)keys.size() ? map.end() : map.find(keys[hi]);
+		using std::distance;
+		ok &= distance(first, last) == hi - lo;
+		ok &= distance(typename Map::const_iterator(first), typename Map::const_iterator(last)) == hi - lo;
+	}
+	std::cout << name << " " << ok << std::endl;
+
+	// An empty map
+	Map empty;
+	std::cout << (empty.rbegin() == empty.rend()) << " " << (empty.crbegin() == empty.crend()) << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+	tester<sjtu::threaded_map<int, int>>("threaded_map");
+
+	// The distance of ranked maps takes O(log n), and throws if last comes before first
+	sjtu::ranked_map<std::string, int> words;
+	for (int i = 0; i < 26; i++)
+		words[std::string(1, 'a' + i)] = i;
+	std::cout << distance(words.begin(), words.find("k")) << " " << distance(words.find("k"), words.end()) << std::endl;
+	try {
+		distance(words.end(), words.begin());
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	for (auto it = words.crbegin(); it != words.crend(); ++it)
+		if (it->second % 5 == 0)
+			std::cout << it->first;
+	std::cout << std::endl;
+	return 0;
+}
@@ -0,0 +1,182 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The value each key is mapped to
+int value_of(int key) { return key * 2; }
+
+// A memory resource counting the bytes it holds
+class counting_resource : public std::pmr::memory_resource {
+  public:
+	long long held = 0;
+
+  private:
+	void *do_allocate(size_t bytes, size_t align) override {
+		held += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, align);
+	}
+	void do_deallocate(void *ptr, size_t bytes, size_t align) override {
+		held -= bytes;
+		std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+	}
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+template <class Map> void fill(Map &map, std::vector<int> &keys, int n, int lo, int hi) {
+	for (int i = 0; i < n; i++) {
+		int key = lo + rnd() % (hi - lo);
+		map[key] = key * 2;
+		auto pos = std::lower_bound(keys.begin(), keys.end(), key);
+		if (pos == keys.end() || *pos != key)
+			keys.insert(pos, key);
+	}
+}
+
+template <class Map> void tester(const char *name) {
+	bool ok = true;
+	// Split at random keys, and join the pieces back
+	for (int round = 0; round < 50; round++) {
+		Map map;
+		std::vector<int> keys;
+		fill(map, keys, rnd() % 2000, 0, 10000);
+		int key = rnd() % 12000 - 1000;
+		size_t mid = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+		Map upper = map.split(key);
+		ok &= check(map, std::vector<int>(keys.begin(), keys.begin() + mid), value_of);
+		ok &= check(upper, std::vector<int>(keys.begin() + mid, keys.end()), value_of);
+		if (round % 2)
+			map.join(upper);
+		else
+			upper.join(map), map.join(upper);
+		ok &= check(map, keys, value_of) && upper.empty();
+	}
+	// Join maps of very different sizes, and keep using them afterwards
+	Map map;
+	std::vector<int> keys;
+	for (int round = 0; round < 20; round++) {
+		Map other;
+		std::vector<int> other_keys;
+		int lo = round * 1000, n = round % 3 == 0 ? 1 : (round % 3 == 1 ? 30 : 800);
+		fill(other, other_keys, n, lo, lo + 1000);
+		map.join(other);
+		keys.insert(keys.end(), other_keys.begin(), other_keys.end());
+		ok &= check(map, keys, value_of) && other.empty();
+		fill(map, keys, 100, 0, lo + 1000);
+		for (int i = 0; i < 50; i++) {
+			auto pos = keys.begin() + rnd() % keys.size();
+			map.erase(map.find(*pos));
+			keys.erase(pos);
+		}
+		ok &= check(map, keys, value_of);
+	}
+	// Split off a piece, let it outlive the map, and keep modifying it
+	Map *whole = new Map(map);
+	Map piece = whole->split(keys[keys.size() / 2]);
+	delete whole;
+	std::vector<int> piece_keys(keys.begin() + keys.size() / 2, keys.end());
+	fill(piece, piece_keys, 500, 10000, 30000);
+	ok &= check(piece, piece_keys, value_of);
+	std::cout << name << " " << map.size() << " " << piece.size() << " " << ok << std::endl;
+
+	// Overlapping ranges cannot be joined
+	Map low, high;
+	low[1] = 2, low[5] = 10, high[3] = 6;
+	try {
+		low.join(high);
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "runtime_error " << low.size() << " " << high.size() << std::endl;
+	}
+}
+
+int main() {
+	tester<sjtu::map<int, int>>("map");
+	tester<sjtu::ranked_map<int, int>>("ranked_map");
+	tester<sjtu::pmr::map<int, int>>("pmr::map");
+
+	// Maps on different memory resources copy the elements when joined
+	std::pmr::monotonic_buffer_resource first, second;
+	sjtu::pmr::map<int, int> a(&first), b(&second);
+	std::vector<int> keys;
+	for (int i = 0; i < 100; i++)
+		a[i] = i * 2, b[i + 100] = (i + 100) * 2, keys.push_back(i);
+	for (int i = 0; i < 100; i++)
+		keys.push_back(i + 100);
+	b.join(a);
+	std::cout << check(b, keys, value_of) << " " << a.empty() << std::endl;
+
+	// Even an empty map moves the elements into its own memory, so it outlives the other resource
+	sjtu::pmr::map<int, int> c(&first);
+	{
+		std::pmr::monotonic_buffer_resource request;
+		sjtu::pmr::map<int, int> d(&request);
+		for (int i = 0; i < 1000; i++)
+			d[i] = i * 2;
+		c.join(d);
+	}
+	keys.clear();
+	for (int i = 0; i < 2000; i++)
+		c[i] = i * 2, keys.push_back(i);
+	std::cout << check(c, keys, value_of) << " " << (c.get_allocator().resource() == &first) << std::endl;
+
+	// The pieces of a split keep their own free lists, so they can be modified from different threads
+	sjtu::map<int, int> left;
+	for (int i = 0; i < 100000; i++)
+		left[i] = i * 2;
+	sjtu::map<int, int> right = left.split(50000);
+	auto churn = [](sjtu::map<int, int> *map, int lo) {
+		for (int round = 0; round < 10; round++)
+			for (int i = 0; i < 50000; i += 2) {
+				map->erase(lo + i);
+				(*map)[lo + i + 1000000] = i;
+				map->erase(lo + i + 1000000);
+				(*map)[lo + i] = (lo + i) * 2;
+			}
+	};
+	std::thread worker(churn, &right, 50000);
+	churn(&left, 0);
+	worker.join();
+	keys.clear();
+	for (int i = 0; i < 50000; i++)
+		keys.push_back(i);
+	bool ok = check(left, keys, value_of);
+	for (int &key : keys)
+		key += 50000;
+	std::cout << (ok && check(right, keys, value_of)) << std::endl;
+
+	// The nodes of a dropped piece are reused by the map it was split from, so the memory stays flat
+	counting_resource counting;
+	sjtu::pmr::map<int, int> whole(&counting);
+	long long peak = 0;
+	bool flat = true;
+	for (int round = 0; round < 10; round++) {
+		for (int i = 0; i < 100000; i++)
+			whole[i] = i * 2;
+		if (round == 0)
+			peak = counting.held;
+		flat &= counting.held == peak;
+		{
+			auto hi = whole.split(50000);
+			flat &= hi.size() == 50000 && whole.size() == 50000;
+		}
+		for (int i = 0; i < 50000; i++)
+			whole.erase(i);
+		flat &= whole.empty();
+	}
+	std::cout << flat << std::endl;
+
+	// Strings
+	sjtu::map<std::string, int> words;
+	for (int i = 0; i < 26; i++)
+		words[std::string(1, 'a' + i)] = i;
+	sjtu::map<std::string, int> tail = words.split("n");
+	std::cout << words.size() << " " << tail.size() << " " << tail.begin()->first << std::endl;
+	words.join(tail);
+	std::cout << words.size() << " " << (--words.end())->first << std::endl;
+	return 0;
+}
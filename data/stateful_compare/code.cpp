@@ -0,0 +1,95 @@
+#include "map.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Orders strings by a collation table, which gives the rank of every letter
+struct Collation {
+	const int *rank;
+	explicit Collation(const int *_rank) : rank(_rank) {}
+	bool operator()(const std::string &a, const std::string &b) const {
+		for (size_t i = 0; i < a.size() && i < b.size(); i++)
+			if (a[i] != b[i])
+				return rank[(unsigned char) a[i]] < rank[(unsigned char) b[i]];
+		return a.size() < b.size();
+	}
+};
+
+// A three-way comparator with state, ordering integers by their remainder first
+struct ByRemainder {
+	using is_three_way = void;
+	int mod;
+	explicit ByRemainder(int _mod) : mod(_mod) {}
+	int operator()(int a, int b) const {
+		if (a % mod != b % mod)
+			return a % mod < b % mod ? -1 : 1;
+		return a < b ? -1 : (a > b ? 1 : 0);
+	}
+};
+
+bool descending(const int &a, const int &b) { return a > b; }
+
+template <class Map> void print(const Map &map) {
+	for (auto it = map.cbegin(); it != map.cend(); ++it)
+		std::cout << it->first << " ";
+	std::cout << std::endl;
+}
+
+int main() {
+	// Stateless comparators take no space in the map
+	std::cout << (sizeof(sjtu::map<int, int>) == sizeof(sjtu::map<int, int, std::greater<int>>)) << " "
+	          << (sizeof(sjtu::map<int, int>) < sizeof(sjtu::map<int, int, ByRemainder>)) << std::endl;
+
+	// Two maps of the same type, ordered by different tables
+	int alphabetical[256], reversed[256];
+	for (int i = 0; i < 256; i++)
+		alphabetical[i] = i, reversed[i] = 255 - i;
+	sjtu::map<std::string, int, Collation> forward{Collation(alphabetical)}, backward{Collation(reversed)};
+	const char *words[] = {"pear", "apple", "fig", "banana", "kiwi", "apricot", "plum"};
+	for (int i = 0; i < 7; i++)
+		forward[words[i]] = backward[words[i]] = i;
+	print(forward);
+	print(backward);
+	std::cout << forward.key_comp()("apple", "banana") << " " << backward.key_comp()("apple", "banana") << " "
+	          << backward.find("kiwi")->second << " " << backward.count("grape") << std::endl;
+
+	// Copies, moves and assignments carry the comparator along
+	sjtu::map<std::string, int, Collation> copy(backward);
+	copy["grape"] = 7;
+	print(copy);
+	sjtu::map<std::string, int, Collation> moved(std::move(copy));
+	moved["cherry"] = 8;
+	print(moved);
+	forward = moved;
+	forward["date"] = 9;
+	print(forward);
+	copy = std::move(forward);
+	copy.erase("pear");
+	print(copy);
+
+	// So does split, and the range constructor takes a comparator as well
+	sjtu::map<std::string, int, Collation> tail = copy.split("fig");
+	tail["apricot"] = 10;
+	print(copy);
+	print(tail);
+	std::vector<sjtu::pair<const std::string, int>> items;
+	for (int i = 0; i < 7; i++)
+		items.push_back(sjtu::pair<const std::string, int>(words[i], i));
+	sjtu::map<std::string, int, Collation> built(items.begin(), items.end(), Collation(reversed));
+	print(built);
+
+	// A stateful three-way comparator
+	sjtu::map<int, int, ByRemainder> remainders{ByRemainder(3)};
+	for (int i = 0; i < 10; i++)
+		remainders[i] = i * i;
+	print(remainders);
+	std::cout << remainders.find(7)->second << " " << remainders.lower_bound(6)->first << " " << remainders.erase(4)
+	          << " " << remainders.size() << std::endl;
+
+	// A function pointer
+	sjtu::map<int, int, bool (*)(const int &, const int &)> pointer(descending);
+	for (int i = 0; i < 5; i++)
+		pointer.insert(sjtu::pair<const int, int>(i, i));
+	print(pointer);
+	return 0;
+}
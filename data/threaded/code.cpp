@@ -0,0 +1,142 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Collects the nodes in order by walking the structure of the tree
+template <class Node> void inorder(Node *cur, std::vector<Node *> &nodes) {
+	if (cur == nullptr)
+		return;
+	inorder(cur->left, nodes);
+	nodes.push_back(cur);
+	inorder(cur->right, nodes);
+}
+
+// Checks the threads against the structure, and the iterators in both directions against the reference
+template <class Map> bool check(Map &map, const std::set<int> &ref) {
+	std::vector<decltype(map.rt)> nodes;
+	inorder(map.rt, nodes);
+	if (nodes.size() != ref.size() || map.size() != ref.size())
+		return false;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i]->pred != (i == 0 ? nullptr : nodes[i - 1]))
+			return false;
+		if (nodes[i]->succ != (i + 1 == nodes.size() ? nullptr : nodes[i + 1]))
+			return false;
+	}
+	auto expected = ref.begin();
+	for (auto it = map.begin(); it != map.end(); ++it, ++expected)
+		if (it->first != *expected)
+			return false;
+	auto reversed = ref.rbegin();
+	for (auto it = map.end(); it != map.begin(); ++reversed)
+		if ((--it)->first != *reversed)
+			return false;
+	return true;
+}
+
+template <class Map> void tester(const char *name) {
+	Map map;
+	std::set<int> ref;
+	bool ok = true;
+	for (int i = 0; i < 20000 && ok; i++) {
+		int key = rnd() % 2000, op = rnd() % 16;
+		if (op < 3) {
+			map[key] = key;
+			ref.insert(key);
+		} else if (op == 3) {
+			map.emplace(key, key);
+			ref.insert(key);
+		} else if (op == 4) {
+			map.insert(map.lower_bound(key), sjtu::pair<const int, int>(key, key));
+			ref.insert(key);
+		} else if (op == 5) {
+			map.insert(sjtu::pair<const int, int>(key, key));
+			ref.insert(key);
+		} else if (op <= 7) {
+			map.erase(key);
+			ref.erase(key);
+		} else if (op == 8 && !ref.empty()) {
+			if (rnd() % 2)
+				ref.erase(ref.begin()), map.pop_front();
+			else
+				ref.erase(--ref.end()), map.pop_back();
+		} else if (op == 9) {
+			Map upper = map.split(key);
+			ok &= check(map, std::set<int>(ref.begin(), ref.lower_bound(key)));
+			ok &= check(upper, std::set<int>(ref.lower_bound(key), ref.end()));
+			if (rnd() % 2)
+				map.join(upper);
+			else
+				upper.join(map), map = std::move(upper);
+		} else if (op == 10 && rnd() % 4 == 0) {
+			int hi = key + rnd() % 200;
+			if (rnd() % 2)
+				map.erase_range(key, hi);
+			else
+				map.erase(map.lower_bound(key), map.lower_bound(hi));
+			ref.erase(ref.lower_bound(key), ref.lower_bound(hi));
+		} else if (op == 11 && !ref.empty()) {
+			// Move a node to another map and back
+			auto handle = map.extract(map.find(*ref.lower_bound(key % (*ref.rbegin() + 1))));
+			Map other;
+			other[key + 5000] = 0;
+			other.insert(std::move(handle));
+			other.erase(key + 5000);
+			map.merge(other);
+		} else if (op == 12 && rnd() % 16 == 0) {
+			Map copy(map);
+			ok &= check(copy, ref);
+			map.clear();
+			map = copy;
+		} else if (op == 13 && rnd() % 16 == 0) {
+			std::vector<sjtu::pair<const int, int>> items;
+			for (auto it = map.cbegin(); it != map.cend(); ++it)
+				items.push_back(*it);
+			Map built(items.begin(), items.end());
+			map = std::move(built);
+		} else if (op == 14) {
+			// Erase while iterating
+			for (auto it = map.lower_bound(key); it != map.end() && it->first < key + 30;)
+				if (it->first % 3 == 0)
+					ref.erase(it->first), it = map.erase(it);
+				else
+					++it;
+		}
+		if (i % 10 == 0)
+			ok &= check(map, ref);
+	}
+	ok &= check(map, ref);
+	std::cout << name << " " << map.size() << " " << ok << std::endl;
+}
+
+int main() {
+	// The threads cost two pointers per node, and nothing without them
+	std::cout << sizeof(sjtu::threaded_map<int, int>::tnode) - sizeof(sjtu::map<int, int>::tnode) << std::endl;
+
+	tester<sjtu::threaded_map<int, int>>("threaded_map");
+	tester<sjtu::map<int, int, std::less<int>, std::allocator<sjtu::pair<const int, int>>, sjtu::tree_policy<true, true>>>(
+	    "threaded ranked_map");
+
+	// Stepping past the ends
+	sjtu::threaded_map<std::string, int> words;
+	words["b"] = 2, words["a"] = 1, words["c"] = 3;
+	for (auto it = words.cbegin(); it != words.cend(); it++)
+		std::cout << it->first << it->second << " ";
+	std::cout << std::endl;
+	try {
+		--words.begin();
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	try {
+		++words.end();
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "invalid_iterator" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include "map.hpp"
+#include "class-rbcheck.hpp"
+#include <iostream>
+#include <map>
+#include <string>
+
+// A strcmp-like comparator
+struct ThreeWay {
+	using is_three_way = void;
+	int operator()(int a, int b) const {
+		comparisons++;
+		return a < b ? -1 : (a > b ? 1 : 0);
+	}
+};
+
+// A strcmp-like comparator declared three-way from outside
+struct Descending {
+	long operator()(int a, int b) const { return (long)b - a; }
+};
+namespace sjtu {
+template <> struct is_three_way_compare<Descending> : std::true_type {};
+} // namespace sjtu
+
+// A boolean comparator which happens to return int
+struct IntLess {
+	int operator()(int a, int b) const { return a < b; }
+};
+
+// A key with a compare() member, like std::string
+struct Word {
+	std::string text;
+	Word(int x) : text(std::to_string(x)) {}
+	int compare(const Word &other) const {
+		comparisons++;
+		return text.compare(other.text);
+	}
+	bool operator<(const Word &other) const {
+		comparisons++;
+		return text < other.text;
+	}
+};
+
+// A key whose compare() member is an equality test, which must not be taken as a three-way result
+struct Tag {
+	int id;
+	Tag(int x) : id(x) {}
+	bool compare(const Tag &other) const { return id == other.id; }
+	bool operator<(const Tag &other) const { return id < other.id; }
+};
+
+template <class Node> int depth(const Node *cur) {
+	return cur == nullptr ? 0 : 1 + std::max(depth(cur->left), depth(cur->right));
+}
+
+// Runs random operations against std::map, and reports whether every lookup compares at most once per level,
+// plus once more to check the equality
+template <class Map, class Key, class Less> void tester(const char *name, Less less) {
+	Map map;
+	std::map<int, int> ref;
+	bool ok = true, cheap = true;
+	for (int i = 0; i < 20000; i++) {
+		int key = rnd() % 3000, op = rnd() % 6;
+		if (op <= 1) {
+			bool inserted = map.insert(sjtu::pair<const Key, int>(Key(key), i)).second;
+			ok &= inserted == ref.insert({key, i}).second;
+		} else if (op == 2) {
+			map[Key(key)] = i;
+			ref[key] = i;
+		} else if (op == 3) {
+			ok &= map.erase(Key(key)) == ref.erase(key);
+		} else {
+			Key probe(key);
+			int height = depth(map.rt);
+			comparisons = 0;
+			auto it = map.find(probe);
+			cheap &= comparisons <= height + 1;
+			auto expected = ref.find(key);
+			ok &= expected == ref.end() ? it == map.end() : (it != map.end() && it->second == expected->second);
+			comparisons = 0;
+			map.count(probe);
+			cheap &= comparisons <= height + 1;
+		}
+	}
+	ok &= map.size() == ref.size() && validate(map.rt, (decltype(map.rt)) nullptr, less) >= 0;
+	std::cout << name << " " << map.size() << " " << ok << " " << cheap << std::endl;
+}
+
+int main() {
+	tester<sjtu::map<int, int, ThreeWay>, int>("three-way", [](int a, int b) { return a < b; });
+	tester<sjtu::map<int, int, Less>, int>("less", [](int a, int b) { return a < b; });
+	tester<sjtu::map<Word, int>, Word>("compare", [](const Word &a, const Word &b) { return a.text < b.text; });
+	tester<sjtu::ranked_map<int, int, ThreeWay>, int>("ranked three-way", [](int a, int b) { return a < b; });
+
+	// A three-way comparator still orders the elements, and answers the other lookups
+	sjtu::map<int, int, ThreeWay> map;
+	for (int i = 0; i < 10; i++)
+		map[i * 10] = i;
+	std::cout << map.lower_bound(25)->first << " " << map.upper_bound(30)->first << " " << map.count(40) << " "
+	          << map.count(45) << " " << map.begin()->first << " " << (--map.end())->first << std::endl;
+	auto range = map.equal_range(50);
+	std::cout << range.first->first << " " << range.second->first << std::endl;
+	std::cout << map.erase_range(20, 60) << " " << map.size() << std::endl;
+
+	// Hinted insertion, emplace and try_emplace with a three-way comparator
+	map.insert(map.find(70), sjtu::pair<const int, int>(65, 1));
+	map.emplace(15, 2);
+	map.try_emplace(15, 3);
+	for (auto it = map.begin(); it != map.end(); ++it)
+		std::cout << it->first << ":" << it->second << " ";
+	std::cout << std::endl;
+
+	// Only the comparators declared three-way are taken as such
+	sjtu::map<int, int, IntLess> ints;
+	sjtu::map<int, int, Descending> descending;
+	for (int i = 0; i < 10; i++)
+		ints[i] = i, descending[i] = i;
+	std::cout << ints.size() << " " << ints.begin()->first << " " << descending.size() << " " << descending.begin()->first
+	          << std::endl;
+
+	// So are the compare() members returning a signed integer
+	sjtu::map<Tag, int> tags;
+	for (int i = 0; i < 10; i++)
+		tags[Tag((i * 7) % 10)] = i;
+	std::cout << tags.size() << " ";
+	for (auto it = tags.begin(); it != tags.end(); ++it)
+		std::cout << it->first.id;
+	std::cout << " " << tags.count(Tag(3)) << " " << tags.count(Tag(10)) << std::endl;
+	return 0;
+}
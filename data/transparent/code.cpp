@@ -0,0 +1,75 @@
+#include "map.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// A key that counts how many times it is built
+struct Name {
+	static int built;
+	std::string text;
+	Name(const char *_text) : text(_text) { built++; }
+	Name(const Name &other) : text(other.text) { built++; }
+};
+int Name::built = 0;
+
+// Compares names with each other and with C strings, by the first letter only for C strings of length 1
+struct NameLess {
+	typedef void is_transparent;
+	bool operator()(const Name &a, const Name &b) const { return a.text < b.text; }
+	bool operator()(const Name &a, const char *b) const {
+		return std::strlen(b) == 1 ? a.text[0] < b[0] : a.text < b;
+	}
+	bool operator()(const char *a, const Name &b) const {
+		return std::strlen(a) == 1 ? a[0] < b.text[0] : a < b.text;
+	}
+};
+
+int main() {
+	sjtu::map<Name, int, NameLess> names;
+	const char *words[] = {"alpha", "bravo", "beta", "charlie", "delta", "echo", "foxtrot", "golf"};
+	for (int i = 0; i < 8; i++)
+		names[words[i]] = i;
+	Name::built = 0;
+
+	// Lookups with C strings build no Name
+	std::cout << names.find("delta")->second << " " << (names.find("zulu") == names.end()) << std::endl;
+	std::cout << names.count("echo") << " " << names.count("x") << " " << names.at("golf") << std::endl;
+	std::cout << names.lower_bound("c")->first.text << " " << names.upper_bound("c")->first.text << std::endl;
+	auto range = names.equal_range("b");
+	for (auto it = range.first; it != range.second; ++it)
+		std::cout << it->first.text << " ";
+	std::cout << std::endl;
+	const auto &const_names = names;
+	std::cout << const_names.find("alpha")->second << " " << const_names.at("beta") << " "
+	          << const_names.lower_bound("d")->first.text << std::endl;
+	try {
+		names.at("zulu");
+		std::cout << "no exception" << std::endl;
+	} catch (sjtu::exception &) {
+		std::cout << "index_out_of_bound" << std::endl;
+	}
+	std::cout << names.erase("echo") << " " << names.erase("echo") << " " << names.size() << std::endl;
+	std::cout << "built " << Name::built << std::endl;
+
+	// Erasing by iterator still works
+	names.erase(names.find("alpha"));
+	names.erase(names.cbegin());
+	std::cout << names.size() << " " << names.begin()->first.text << std::endl;
+
+	// std::less<> compares std::string with std::string_view and C strings directly
+	sjtu::map<std::string, int, std::less<>> routes;
+	routes["/api/users"] = 1;
+	routes["/api/orders"] = 2;
+	routes["/static"] = 3;
+	std::string_view path = "/api/orders/42";
+	std::cout << routes.count(path.substr(0, 11)) << " " << routes.at(std::string_view("/static")) << " "
+	          << routes.find("/api/users")->second << " " << routes.erase(std::string_view("/static")) << " "
+	          << routes.size() << std::endl;
+
+	// Plain comparators convert the key as before
+	sjtu::map<std::string, int> plain;
+	plain["a"] = 1;
+	std::cout << plain.count("a") << " " << plain.erase("a") << " " << plain.size() << std::endl;
+	return 0;
+}
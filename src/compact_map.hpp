@@ -0,0 +1,677 @@
+/**
+ * implement a compact container like std::map, whose nodes are linked by 32-bit indices
+ */
+#ifndef SJTU_COMPACT_MAP_HPP
+#define SJTU_COMPACT_MAP_HPP
+
+#include "exceptions.hpp"
+#include "map.hpp"
+#include "utility.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace sjtu {
+
+/**
+ * @brief a red-black tree with the same interface as sjtu::map, but a compact storage engine.
+ * The nodes are kept in a contiguous array and linked by 32-bit indices, with the color packed into the highest bit of
+ * the parent index, so that a node costs 12 bytes besides its data (sjtu::map costs 40 bytes).
+ * Slot 0 works as the nil sentinel, and the freed slots are recycled through a free list.
+ * Iterators refer to the nodes by index, so they stay valid when the array grows.
+ * But the array grows by reallocation, which moves the elements: unlike sjtu::map, a reference or pointer to an element
+ * (e.g. one returned by operator[] or at()) is invalidated by any insertion that may grow the array.
+ * Keep an iterator instead, or look the element up again after inserting.
+ * The comparator is kept and used as in sjtu::map, so it may have state, and a three-way comparator
+ * (see is_three_way_compare) costs a single comparison on each level.
+ */
+template <class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>>
+class compact_map : private compare_holder<Compare> {
+  public:
+    typedef pair<const Key, T> value_type;
+    typedef uint32_t index_type;
+    typedef Allocator allocator_type;
+
+  private:
+    struct slot {
+        index_type left, right;
+        // the index of parent, with the color in the highest bit
+        index_type parent_col;
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+
+        value_type &data() { return *reinterpret_cast<value_type *>(storage); }
+        const value_type &data() const { return *reinterpret_cast<const value_type *>(storage); }
+    };
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+    using slot_traits = std::allocator_traits<slot_allocator>;
+
+    static constexpr index_type NIL = 0;
+    static constexpr index_type RED_BIT = 0x80000000u;
+    // The parent field of a free slot, which is never a valid (index, color) pair since the capacity is below it
+    static constexpr index_type FREE = 0xffffffffu;
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr size_t MAX_CAPACITY = RED_BIT - 1;
+    // Whether comparing two keys tells less, equal and greater apart in a single call
+    static constexpr bool three_way_keys = is_three_way_compare<Compare>::value || has_compare_member<Compare, Key, Key>::value;
+
+  public:
+    /**
+     * see BidirectionalIterator at CppReference for help.
+     *
+     * if there is anything wrong throw invalid_iterator.
+     *     like it = map.begin(); --it;
+     *       or it = map.end(); ++end();
+     */
+    template <bool const_tag> class base_iterator {
+        friend class compact_map;
+        friend class base_iterator<true>;
+        friend class base_iterator<false>;
+
+      protected:
+        const compact_map *iter;
+        index_type idx;
+
+      public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = typename compact_map::value_type;
+        using iterator_category = std::bidirectional_iterator_tag;
+        using pointer = typename std::conditional<const_tag, const value_type *, value_type *>::type;
+        using reference = typename std::conditional<const_tag, const value_type &, value_type &>::type;
+        using iterator_assignable = typename std::conditional<const_tag, my_false_type, my_true_type>::type;
+
+        base_iterator() : iter(nullptr), idx(NIL) {}
+        template <bool _const_tag>
+        base_iterator(const base_iterator<_const_tag> &other) : iter(other.iter), idx(other.idx) {}
+        base_iterator(const compact_map *_iter, index_type _idx) : iter(_iter), idx(_idx) {}
+
+        base_iterator operator++(int) {
+            base_iterator cp = *this;
+            ++*this;
+            return cp;
+        }
+        base_iterator &operator++() {
+            if (iter == nullptr || idx == NIL)
+                throw invalid_iterator();
+            idx = iter->next(idx);
+            return *this;
+        }
+        base_iterator operator--(int) {
+            base_iterator cp = *this;
+            --*this;
+            return cp;
+        }
+        base_iterator &operator--() {
+            if (iter == nullptr)
+                throw invalid_iterator();
+            idx = idx == NIL ? iter->last() : iter->prev(idx);
+            if (idx == NIL)
+                throw invalid_iterator();
+            return *this;
+        }
+
+        template <bool _const_tag> bool operator==(const base_iterator<_const_tag> &rhs) const {
+            return iter == rhs.iter && idx == rhs.idx;
+        }
+        template <bool _const_tag> bool operator!=(const base_iterator<_const_tag> &rhs) const {
+            return iter != rhs.iter || idx != rhs.idx;
+        }
+
+        reference operator*() const { return iter->nodes[idx].data(); }
+        pointer operator->() const { return &iter->nodes[idx].data(); }
+    };
+
+    using iterator = base_iterator<false>;
+    using const_iterator = base_iterator<true>;
+
+    compact_map() : compact_map(Allocator()) {}
+    explicit compact_map(const Allocator &_alloc)
+        : alloc(_alloc), nodes(nullptr), capacity(0), used(0), root(NIL), free_head(NIL), node_count(0) {}
+    explicit compact_map(const Compare &comp, const Allocator &_alloc = Allocator())
+        : compare_holder<Compare>(comp), alloc(_alloc), nodes(nullptr), capacity(0), used(0), root(NIL), free_head(NIL),
+          node_count(0) {}
+    compact_map(const compact_map &other)
+        : compare_holder<Compare>(other), alloc(slot_traits::select_on_container_copy_construction(other.alloc)),
+          nodes(nullptr), capacity(0), used(0), root(NIL), free_head(NIL), node_count(0) {
+        copy_from(other);
+    }
+    compact_map &operator=(const compact_map &other) {
+        if (this == &other)
+            return *this;
+        clear();
+        compare_holder<Compare>::operator=(other);
+        if (slot_traits::propagate_on_container_copy_assignment::value)
+            alloc = other.alloc;
+        copy_from(other);
+        return *this;
+    }
+    ~compact_map() { clear(); }
+
+    Allocator get_allocator() const { return Allocator(alloc); }
+    Compare key_comp() const { return this->comparator(); }
+
+    /**
+     * access specified element with bounds checking
+     * If no such element exists, an exception of type `index_out_of_bound'
+     */
+    T &at(const Key &key) {
+        index_type res = find_index(key);
+        if (res == NIL)
+            throw index_out_of_bound();
+        return nodes[res].data().second;
+    }
+    const T &at(const Key &key) const {
+        index_type res = find_index(key);
+        if (res == NIL)
+            throw index_out_of_bound();
+        return nodes[res].data().second;
+    }
+    /**
+     * access specified element, performing an insertion if such key does not already exist.
+     */
+    T &operator[](const Key &key) {
+        // The array may be moved by the insertion, so don't touch it before that
+        index_type res = insert_unique({key, T()}).first;
+        return nodes[res].data().second;
+    }
+    /**
+     * behave like at() throw index_out_of_bound if such key does not exist.
+     */
+    const T &operator[](const Key &key) const { return at(key); }
+
+    iterator begin() { return iterator(this, first()); }
+    const_iterator cbegin() const { return const_iterator(this, first()); }
+    iterator end() { return iterator(this, NIL); }
+    const_iterator cend() const { return const_iterator(this, NIL); }
+
+    bool empty() const { return node_count == 0; }
+    size_t size() const { return node_count; }
+    /**
+     * @brief clear the contents, and return the array to the allocator
+     *
+     */
+    void clear() {
+        if (nodes == nullptr)
+            return;
+        if (!std::is_trivially_destructible<value_type>::value)
+            for (index_type i = 1; i < used; i++)
+                if (nodes[i].parent_col != FREE)
+                    nodes[i].data().~value_type();
+        slot_traits::deallocate(alloc, nodes, capacity);
+        nodes = nullptr;
+        capacity = used = 0;
+        root = free_head = NIL;
+        node_count = 0;
+    }
+
+    /**
+     * insert an element.
+     * return a pair, the first of the pair is
+     *   the iterator to the new element (or the element that prevented the insertion),
+     *   the second one is true if insert successfully, or false.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        auto res = insert_unique(value);
+        return {iterator(this, res.first), res.second};
+    }
+    /**
+     * erase the element at pos.
+     *
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+     */
+    void erase(iterator pos) {
+        if (pos.iter != this || pos.idx == NIL)
+            throw index_out_of_bound();
+        erase_node(pos.idx);
+    }
+
+    iterator find(const Key &key) { return iterator(this, find_index(key)); }
+    const_iterator find(const Key &key) const { return const_iterator(this, find_index(key)); }
+    size_t count(const Key &key) const { return find_index(key) == NIL ? 0 : 1; }
+
+  private:
+    const Key &key_of(index_type x) const { return nodes[x].data().first; }
+    index_type left(index_type x) const { return nodes[x].left; }
+    index_type right(index_type x) const { return nodes[x].right; }
+    index_type parent(index_type x) const { return nodes[x].parent_col & ~RED_BIT; }
+    void set_parent(index_type x, index_type p) { nodes[x].parent_col = (nodes[x].parent_col & RED_BIT) | p; }
+    bool is_red(index_type x) const { return nodes[x].parent_col & RED_BIT; }
+    void set_red(index_type x) { nodes[x].parent_col |= RED_BIT; }
+    void set_black(index_type x) { nodes[x].parent_col &= ~RED_BIT; }
+    void set_color(index_type x, bool red) { red ? set_red(x) : set_black(x); }
+
+    /**
+     * @brief whether a < b under Compare
+     */
+    bool key_less(const Key &a, const Key &b) const {
+        if constexpr (is_three_way_compare<Compare>::value)
+            return this->comparator()(a, b) < 0;
+        else
+            return this->comparator()(a, b);
+    }
+    /**
+     * @brief compare a with b in a single call, which needs three_way_keys
+     *
+     * @return a negative number if a < b, zero if a = b, and a positive number if a > b
+     */
+    int key_compare(const Key &a, const Key &b) const {
+        if constexpr (is_three_way_compare<Compare>::value) {
+            auto comp = this->comparator()(a, b);
+            return comp < 0 ? -1 : (comp > 0);
+        } else {
+            auto comp = a.compare(b);
+            return comp < 0 ? -1 : (comp > 0);
+        }
+    }
+
+    /**
+     * @brief find the node with the selected key.
+     * Without a three-way comparison, it compares once on each level like lower_bound() in sjtu::map,
+     * and checks the equality only at the end.
+     *
+     * @param key
+     * @return NIL if there's no such node
+     */
+    index_type find_index(const Key &key) const {
+        index_type cur = root, res = NIL;
+        while (cur != NIL) {
+            if constexpr (three_way_keys) {
+                int comp = key_compare(key, key_of(cur));
+                if (!comp)
+                    return cur;
+                cur = comp < 0 ? left(cur) : right(cur);
+            } else if (key_less(key_of(cur), key)) {
+                cur = right(cur);
+            } else {
+                res = cur;
+                cur = left(cur);
+            }
+        }
+        return res != NIL && !key_less(key, key_of(res)) ? res : NIL;
+    }
+
+    index_type minimum(index_type x) const {
+        while (left(x) != NIL)
+            x = left(x);
+        return x;
+    }
+    index_type maximum(index_type x) const {
+        while (right(x) != NIL)
+            x = right(x);
+        return x;
+    }
+    index_type first() const { return root == NIL ? NIL : minimum(root); }
+    index_type last() const { return root == NIL ? NIL : maximum(root); }
+
+    index_type next(index_type x) const {
+        if (right(x) != NIL)
+            return minimum(right(x));
+        index_type p = parent(x);
+        while (p != NIL && x == right(p)) {
+            x = p;
+            p = parent(p);
+        }
+        return p;
+    }
+    /**
+     * @throw invalid_iterator when passing the first node
+     */
+    index_type prev(index_type x) const {
+        if (left(x) != NIL)
+            return maximum(left(x));
+        index_type p = parent(x);
+        while (p != NIL && x == left(p)) {
+            x = p;
+            p = parent(p);
+        }
+        if (p == NIL)
+            throw invalid_iterator();
+        return p;
+    }
+
+    /**
+     * @brief insert the value if its key doesn't exist, comparing like find_index()
+     *
+     * @param value
+     * @return the index of the element with the key, and whether it's newly inserted
+     */
+    pair<index_type, bool> insert_unique(const value_type &value) {
+        // same is the last node on the path not less than the key, which is the only one that may equal it
+        index_type cur = root, par = NIL, same = NIL;
+        bool to_left = true;
+        while (cur != NIL) {
+            par = cur;
+            if constexpr (three_way_keys) {
+                int comp = key_compare(value.first, key_of(cur));
+                if (!comp)
+                    return {cur, false};
+                to_left = comp < 0;
+            } else {
+                to_left = !key_less(key_of(cur), value.first);
+                if (to_left)
+                    same = cur;
+            }
+            cur = to_left ? left(cur) : right(cur);
+        }
+        if (same != NIL && !key_less(value.first, key_of(same)))
+            return {same, false};
+        index_type res = node_create(value);
+        nodes[res].parent_col = RED_BIT | par;
+        if (par == NIL)
+            root = res;
+        else if (to_left)
+            nodes[par].left = res;
+        else
+            nodes[par].right = res;
+        node_count++;
+        insert_fixup(res);
+        return {res, true};
+    }
+
+    /**
+     * @brief Fix the red-red link between the inserted node and its parent, bottom-up
+     *
+     * @param cur
+     */
+    void insert_fixup(index_type cur) {
+        while (is_red(parent(cur))) {
+            index_type par = parent(cur), grand = parent(par);
+            if (par == left(grand)) {
+                index_type uncle = right(grand);
+                if (is_red(uncle)) {
+                    set_black(par);
+                    set_black(uncle);
+                    set_red(grand);
+                    cur = grand;
+                    continue;
+                }
+                if (cur == right(par)) {
+                    cur = par;
+                    left_rotate(cur);
+                    par = parent(cur);
+                }
+                set_black(par);
+                set_red(grand);
+                right_rotate(grand);
+            } else {
+                index_type uncle = left(grand);
+                if (is_red(uncle)) {
+                    set_black(par);
+                    set_black(uncle);
+                    set_red(grand);
+                    cur = grand;
+                    continue;
+                }
+                if (cur == left(par)) {
+                    cur = par;
+                    right_rotate(cur);
+                    par = parent(cur);
+                }
+                set_black(par);
+                set_red(grand);
+                left_rotate(grand);
+            }
+        }
+        set_black(root);
+    }
+
+    /**
+     * @brief Replace the subtree rooted at u with the subtree rooted at v.
+     * Notice: the parent of nil may be set here, which is used by erase_fixup.
+     */
+    void transplant(index_type u, index_type v) {
+        index_type par = parent(u);
+        if (par == NIL)
+            root = v;
+        else if (u == left(par))
+            nodes[par].left = v;
+        else
+            nodes[par].right = v;
+        set_parent(v, par);
+    }
+
+    void erase_node(index_type del) {
+        index_type moved = del, replacement;
+        bool removed_red = is_red(moved);
+        if (left(del) == NIL) {
+            replacement = right(del);
+            transplant(del, replacement);
+        } else if (right(del) == NIL) {
+            replacement = left(del);
+            transplant(del, replacement);
+        } else {
+            // Move its successor to its position
+            moved = minimum(right(del));
+            removed_red = is_red(moved);
+            replacement = right(moved);
+            if (parent(moved) == del) {
+                set_parent(replacement, moved);
+            } else {
+                transplant(moved, right(moved));
+                nodes[moved].right = right(del);
+                set_parent(right(moved), moved);
+            }
+            transplant(del, moved);
+            nodes[moved].left = left(del);
+            set_parent(left(moved), moved);
+            set_color(moved, is_red(del));
+        }
+        if (!removed_red)
+            erase_fixup(replacement);
+        node_delete(del);
+        node_count--;
+    }
+
+    /**
+     * @brief Fix the extra black on the selected node after erasing, bottom-up
+     *
+     * @param cur
+     */
+    void erase_fixup(index_type cur) {
+        while (cur != root && !is_red(cur)) {
+            index_type par = parent(cur);
+            if (cur == left(par)) {
+                index_type sib = right(par);
+                if (is_red(sib)) {
+                    set_black(sib);
+                    set_red(par);
+                    left_rotate(par);
+                    sib = right(par);
+                }
+                if (!is_red(left(sib)) && !is_red(right(sib))) {
+                    set_red(sib);
+                    cur = par;
+                    continue;
+                }
+                if (!is_red(right(sib))) {
+                    set_black(left(sib));
+                    set_red(sib);
+                    right_rotate(sib);
+                    sib = right(par);
+                }
+                set_color(sib, is_red(par));
+                set_black(par);
+                set_black(right(sib));
+                left_rotate(par);
+                cur = root;
+            } else {
+                index_type sib = left(par);
+                if (is_red(sib)) {
+                    set_black(sib);
+                    set_red(par);
+                    right_rotate(par);
+                    sib = left(par);
+                }
+                if (!is_red(left(sib)) && !is_red(right(sib))) {
+                    set_red(sib);
+                    cur = par;
+                    continue;
+                }
+                if (!is_red(left(sib))) {
+                    set_black(right(sib));
+                    set_red(sib);
+                    left_rotate(sib);
+                    sib = left(par);
+                }
+                set_color(sib, is_red(par));
+                set_black(par);
+                set_black(left(sib));
+                right_rotate(par);
+                cur = root;
+            }
+        }
+        set_black(cur);
+    }
+
+    /**
+     * @brief Rotate the selected node to its left child, with its right child replacing the current position
+     */
+    void left_rotate(index_type cur) {
+        index_type tmp = right(cur);
+        nodes[cur].right = left(tmp);
+        if (left(tmp) != NIL)
+            set_parent(left(tmp), cur);
+        transplant(cur, tmp);
+        nodes[tmp].left = cur;
+        set_parent(cur, tmp);
+    }
+    /**
+     * @brief Rotate the selected node to its right child, with its left child replacing the current position
+     */
+    void right_rotate(index_type cur) {
+        index_type tmp = left(cur);
+        nodes[cur].left = right(tmp);
+        if (right(tmp) != NIL)
+            set_parent(right(tmp), cur);
+        transplant(cur, tmp);
+        nodes[tmp].right = cur;
+        set_parent(cur, tmp);
+    }
+
+  private:
+    /**
+     * @brief take a slot from the free list, or from the end of the array, and construct the data in it
+     *
+     * @param value
+     * @return index_type
+     */
+    index_type node_create(const value_type &value) {
+        index_type res;
+        if (free_head != NIL) {
+            res = free_head;
+            free_head = left(res);
+        } else {
+            if (used == capacity)
+                grow();
+            res = used++;
+        }
+        try {
+            // Only the array goes through the allocator, the data is constructed in place
+            ::new (static_cast<void *>(nodes[res].storage)) value_type(value);
+        } catch (...) {
+            node_release(res);
+            throw;
+        }
+        nodes[res].left = nodes[res].right = NIL;
+        return res;
+    }
+    void node_delete(index_type x) {
+        nodes[x].data().~value_type();
+        node_release(x);
+    }
+    void node_release(index_type x) {
+        nodes[x].parent_col = FREE;
+        nodes[x].left = free_head;
+        free_head = x;
+    }
+
+    /**
+     * @brief double the array, moving the data of live slots into the new one
+     *
+     */
+    void grow() {
+        size_t new_capacity = capacity ? capacity * 2 : MIN_CAPACITY;
+        if (new_capacity > MAX_CAPACITY)
+            new_capacity = MAX_CAPACITY;
+        if (new_capacity <= used)
+            throw runtime_error();
+        slot *res = slot_traits::allocate(alloc, new_capacity);
+        index_type moved = 1;
+        try {
+            for (; moved < used; moved++)
+                if (nodes[moved].parent_col != FREE)
+                    ::new (static_cast<void *>(res[moved].storage)) value_type(std::move_if_noexcept(nodes[moved].data()));
+        } catch (...) {
+            for (index_type i = 1; i < moved; i++)
+                if (nodes[i].parent_col != FREE)
+                    res[i].data().~value_type();
+            slot_traits::deallocate(alloc, res, new_capacity);
+            throw;
+        }
+        if (nodes == nullptr) {
+            // Set up the nil sentinel
+            res[NIL].left = res[NIL].right = NIL;
+            res[NIL].parent_col = NIL;
+            used = 1;
+        } else {
+            for (index_type i = 0; i < used; i++) {
+                res[i].left = nodes[i].left;
+                res[i].right = nodes[i].right;
+                res[i].parent_col = nodes[i].parent_col;
+                if (i != NIL && nodes[i].parent_col != FREE)
+                    nodes[i].data().~value_type();
+            }
+            slot_traits::deallocate(alloc, nodes, capacity);
+        }
+        nodes = res;
+        capacity = new_capacity;
+    }
+
+    /**
+     * @brief copy the slots of another map by index, so that the structure is kept as is
+     *
+     * @param other an empty map
+     */
+    void copy_from(const compact_map &other) {
+        if (other.nodes == nullptr)
+            return;
+        nodes = slot_traits::allocate(alloc, other.used);
+        capacity = other.used;
+        index_type copied = 1;
+        try {
+            for (; copied < other.used; copied++)
+                if (other.nodes[copied].parent_col != FREE)
+                    ::new (static_cast<void *>(nodes[copied].storage)) value_type(other.nodes[copied].data());
+        } catch (...) {
+            for (index_type i = 1; i < copied; i++)
+                if (other.nodes[i].parent_col != FREE)
+                    nodes[i].data().~value_type();
+            slot_traits::deallocate(alloc, nodes, capacity);
+            nodes = nullptr;
+            capacity = 0;
+            throw;
+        }
+        for (index_type i = 0; i < other.used; i++) {
+            nodes[i].left = other.nodes[i].left;
+            nodes[i].right = other.nodes[i].right;
+            nodes[i].parent_col = other.nodes[i].parent_col;
+        }
+        used = other.used;
+        root = other.root;
+        free_head = other.free_head;
+        node_count = other.node_count;
+    }
+
+    slot_allocator alloc;
+    slot *nodes;
+    // the number of slots allocated, and the number of slots ever used (including nil)
+    index_type capacity, used;
+    index_type root, free_head;
+    size_t node_count;
+};
+
+} // namespace sjtu
+
+#endif
@@ -7,12 +7,468 @@
 // only for std::less<T>
 #include "exceptions.hpp"
 #include "utility.hpp"
+#include <atomic>
 #include <cstddef>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
 
 namespace sjtu {
 
-template <class Key, class T, class Compare = std::less<Key>> class RBTree {
+/**
+ * @brief check whether the allocator destroys an object by simply calling its destructor,
+ * i.e. it doesn't have its own destroy(), or it's a std::allocator or a std::pmr::polymorphic_allocator.
+ *
+ * @tparam Alloc
+ * @tparam Node
+ */
+template <class Alloc, class Node, class = void> struct allocator_destroys_plainly : std::true_type {};
+template <class Alloc, class Node>
+struct allocator_destroys_plainly<Alloc, Node, std::void_t<decltype(std::declval<Alloc &>().destroy(std::declval<Node *>()))>>
+    : std::integral_constant<bool, std::is_same<Alloc, std::allocator<Node>>::value ||
+                                       std::is_same<Alloc, std::pmr::polymorphic_allocator<Node>>::value> {};
+
+/**
+ * @brief check whether Compare is a three-way comparator, i.e. it returns a negative, zero or positive integer
+ * (like strcmp) instead of a bool, so that a single call tells less, equal and greater apart.
+ * A comparator opts in by declaring a member type is_three_way, as is_transparent does for heterogeneous lookup,
+ * since returning an integer alone doesn't tell (e.g. an int returning a < b).
+ * The trait can also be specialized for a comparator which cannot declare the member.
+ *
+ * @tparam Compare
+ */
+template <class Compare, class = void> struct is_three_way_compare : std::false_type {};
+template <class Compare> struct is_three_way_compare<Compare, std::void_t<typename Compare::is_three_way>> : std::true_type {};
+
+/**
+ * @brief check whether Compare is std::less and the keys have a compare() member returning a signed integer
+ * (e.g. std::string), which can stand for the comparator when a three-way result is needed.
+ * A bool or unsigned result cannot be negative, so it is not taken as a three-way result (e.g. an equality test).
+ *
+ * @tparam Compare
+ * @tparam A
+ * @tparam B
+ */
+template <class Compare, class A, class B, class = void> struct has_compare_member : std::false_type {};
+template <class Compare, class A, class B>
+struct has_compare_member<Compare, A, B, std::void_t<decltype(std::declval<const A &>().compare(std::declval<const B &>()))>>
+    : std::integral_constant<bool, (std::is_same<Compare, std::less<A>>::value || std::is_same<Compare, std::less<>>::value) &&
+                                       std::is_integral<decltype(std::declval<const A &>().compare(std::declval<const B &>()))>::value &&
+                                       !std::is_same<decltype(std::declval<const A &>().compare(std::declval<const B &>())), bool>::value &&
+                                       std::is_signed<decltype(std::declval<const A &>().compare(std::declval<const B &>()))>::value> {};
+
+/**
+ * @brief hint the processor to start loading the memory at ptr into the cache, if the compiler supports it.
+ * It never faults, so ptr may be nullptr.
+ *
+ * @param ptr
+ */
+inline void prefetch(const void *ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    (void)ptr;
+#endif
+}
+
+/**
+ * @brief the comparator of a tree.
+ * A stateless comparator is kept as an empty base, so that it takes no space in the tree,
+ * while a comparator with state (or a function pointer) is kept as a member.
+ *
+ * @tparam Compare
+ */
+template <class Compare, bool = std::is_empty<Compare>::value && !std::is_final<Compare>::value>
+class compare_holder : private Compare {
+  public:
+    explicit compare_holder(const Compare &comp = Compare()) : Compare(comp) {}
+    const Compare &comparator() const { return *this; }
+};
+template <class Compare> class compare_holder<Compare, false> {
+  public:
+    explicit compare_holder(const Compare &_comp = Compare()) : comp(_comp) {}
+    const Compare &comparator() const { return comp; }
+
+  private:
+    Compare comp;
+};
+
+/**
+ * @brief a pool of tree nodes.
+ * It carves the nodes out of large chunks, and recycles the freed nodes through a free list,
+ * so that the tree doesn't pay a malloc/free for every insertion and deletion.
+ * The chunks are arrays of Node, allocated by the allocator rebound to Node.
+ * The pool only manages raw storage: constructing and destructing the nodes is left to the caller.
+ *
+ * When nodes move from one tree to another (e.g. by split or join), the two pools must share their chunks,
+ * since a node lives in the chunk it was carved from. So the chunks are kept in a reference-counted state:
+ * sharing merges the states of two pools into one in O(1), and the chunks go back to the allocator only when
+ * no pool refers to them any more. A merged state forwards to the state it was merged into,
+ * and the pools still referring to it follow the forwarding lazily.
+ *
+ * Every pool takes and frees nodes through a free list of its own, so that trees sharing a state can still be
+ * modified from different threads. The state is locked only when a pool runs out of free nodes: the pool then takes
+ * the nodes other pools have given back, or carves a new chunk if there's none. A released pool gives its free nodes
+ * back to the state, so that they are reused by the pools still sharing it instead of being lost.
+ *
+ * @tparam Node
+ * @tparam Allocator
+ */
+template <class Node, class Allocator = std::allocator<Node>>
+class node_pool : private std::allocator_traits<Allocator>::template rebind_alloc<Node> {
+  public:
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using allocator_traits = std::allocator_traits<allocator_type>;
+
+    explicit node_pool(const allocator_type &alloc = allocator_type())
+        : allocator_type(alloc), state(nullptr), free_list(nullptr), free_tail(nullptr), cursor(nullptr), limit(nullptr),
+          next_capacity(MIN_CHUNK) {}
+    node_pool(const node_pool &) = delete;
+    node_pool &operator=(const node_pool &) = delete;
+    node_pool(node_pool &&other) noexcept
+        : allocator_type(std::move(other.get_allocator())), state(other.state), free_list(other.free_list),
+          free_tail(other.free_tail), cursor(other.cursor), limit(other.limit), next_capacity(other.next_capacity) {
+        other.forget();
+    }
+    /**
+     * @brief take over the chunks of another pool.
+     * Notice: the allocators of the two pools should be equal, or propagated on move assignment,
+     * since the chunks have to be returned to the allocator they came from.
+     *
+     * @param other
+     * @return node_pool&
+     */
+    node_pool &operator=(node_pool &&other) noexcept {
+        if (this == &other)
+            return *this;
+        release();
+        if constexpr (allocator_traits::propagate_on_container_move_assignment::value)
+            get_allocator() = std::move(other.get_allocator());
+        state = other.state;
+        free_list = other.free_list;
+        free_tail = other.free_tail;
+        cursor = other.cursor;
+        limit = other.limit;
+        next_capacity = other.next_capacity;
+        other.forget();
+        return *this;
+    }
+    ~node_pool() { release(); }
+
+    allocator_type &get_allocator() { return *this; }
+    const allocator_type &get_allocator() const { return *this; }
+
+    /**
+     * @brief get the storage of a node, from the free list if possible
+     *
+     * @return Node*
+     */
+    Node *allocate() {
+        if (free_list == nullptr && cursor == limit)
+            refill();
+        if (free_list != nullptr) {
+            free_slot *res = free_list;
+            free_list = res->next;
+            if (free_list == nullptr)
+                free_tail = nullptr;
+            return reinterpret_cast<Node *>(res);
+        }
+        return cursor++;
+    }
+    /**
+     * @brief give the storage of a (destructed) node back to the free list of this pool
+     *
+     * @param ptr
+     */
+    void deallocate(Node *ptr) {
+        free_slot *res = reinterpret_cast<free_slot *>(ptr);
+        res->next = free_list;
+        if (free_list == nullptr)
+            free_tail = res;
+        free_list = res;
+    }
+    /**
+     * @brief check whether the chunks are used by this pool only
+     *
+     * @return true if no other pool shares the chunks
+     */
+    bool exclusive() {
+        pool_state *cur = resolve();
+        return cur == nullptr || cur->refs.load(std::memory_order_acquire) == 1;
+    }
+    /**
+     * @brief give the free nodes back to the pools sharing the chunks, and drop this pool's share of the chunks,
+     *   which go back to the allocator if no other pool shares them.
+     * Notice: every node of this pool should have been destructed, or moved to a pool sharing the chunks.
+     *
+     */
+    void release() {
+        if (!exclusive())
+            give_back();
+        drop(state);
+        forget();
+    }
+    /**
+     * @brief make the two pools share the same chunks in O(1), so that nodes can move between them.
+     * Nodes cannot move between pools whose allocators are not equal,
+     * since they have to be returned to the allocator they came from.
+     *
+     * @param other
+     * @return false if the allocators are not equal, in which case nothing is shared
+     */
+    bool share(node_pool &other) {
+        if (this == &other)
+            return true;
+        if (!(get_allocator() == other.get_allocator()))
+            return false;
+        while (true) {
+            pool_state *cur = resolve(), *target = other.resolve();
+            if (target == nullptr || cur == target)
+                return true;
+            if (cur == nullptr) {
+                // Simply join the chunks of the other pool if this one doesn't have any
+                target->refs.fetch_add(1, std::memory_order_relaxed);
+                state = target;
+                return true;
+            }
+            std::lock(cur->lock, target->lock);
+            std::lock_guard<std::mutex> hold_cur(cur->lock, std::adopt_lock), hold_target(target->lock, std::adopt_lock);
+            // Retry if a pool sharing either state has merged it meanwhile
+            if (cur->forward.load(std::memory_order_relaxed) == nullptr &&
+                target->forward.load(std::memory_order_relaxed) == nullptr) {
+                absorb(cur, target);
+                return true;
+            }
+        }
+    }
+    /**
+     * @brief replace the allocator, which is only allowed when the pool holds no nodes
+     *
+     * @param alloc
+     */
+    void reset_allocator(const allocator_type &alloc) {
+        release();
+        get_allocator() = alloc;
+    }
+
+  private:
+    // A freed node is reused as a link of the free list
+    struct free_slot {
+        free_slot *next;
+    };
+    // The header of a chunk takes the first node of it
+    struct chunk_header {
+        Node *next;
+        size_t capacity;
+    };
+    static_assert(sizeof(chunk_header) <= sizeof(Node), "The node is too small to be pooled.");
+    // The chunks grow geometrically, so that small maps don't waste memory and large maps don't call malloc frequently
+    static constexpr size_t MIN_CHUNK = 16;
+    static constexpr size_t MAX_CHUNK = 4096;
+
+    struct pool_state {
+        // guards the chunks and the free list, which the pools only touch when they run out of free nodes
+        std::mutex lock;
+        Node *chunks, *chunks_tail;
+        // the nodes given back by released pools
+        free_slot *free_list, *free_tail;
+        // the number of pools and states referring to this state
+        std::atomic<size_t> refs;
+        // the state which this one has been merged into
+        std::atomic<pool_state *> forward;
+
+        pool_state()
+            : chunks(nullptr), chunks_tail(nullptr), free_list(nullptr), free_tail(nullptr), refs(1), forward(nullptr) {}
+    };
+    using state_allocator = typename allocator_traits::template rebind_alloc<pool_state>;
+    using state_traits = std::allocator_traits<state_allocator>;
+
+    pool_state *state;
+    free_slot *free_list, *free_tail;
+    // The unused part of the latest chunk
+    Node *cursor, *limit;
+    size_t next_capacity;
+
+    // Reset the pool to the empty state, without touching the chunks
+    void forget() {
+        state = nullptr;
+        free_list = free_tail = nullptr;
+        cursor = limit = nullptr;
+        next_capacity = MIN_CHUNK;
+    }
+    /**
+     * @brief follow the forwarding to the state actually holding the chunks
+     *
+     * @return nullptr if the pool doesn't have a state yet
+     */
+    pool_state *resolve() {
+        while (state != nullptr) {
+            pool_state *next = state->forward.load(std::memory_order_acquire);
+            if (next == nullptr)
+                break;
+            next->refs.fetch_add(1, std::memory_order_relaxed);
+            drop(state);
+            state = next;
+        }
+        return state;
+    }
+    pool_state *acquire() {
+        if (resolve() == nullptr) {
+            state_allocator alloc(get_allocator());
+            pool_state *res = &*state_traits::allocate(alloc, 1);
+            state_traits::construct(alloc, res);
+            state = res;
+        }
+        return state;
+    }
+    /**
+     * @brief lock the state actually holding the chunks, which may be merged into another one before it's locked
+     *
+     * @return the lock of state
+     */
+    std::unique_lock<std::mutex> lock_state() {
+        while (true) {
+            pool_state *cur = acquire();
+            std::unique_lock<std::mutex> res(cur->lock);
+            if (cur->forward.load(std::memory_order_relaxed) == nullptr)
+                return res;
+        }
+    }
+    /**
+     * @brief remove a reference to the state, and destruct it if no one refers to it
+     *
+     * @param cur
+     */
+    void drop(pool_state *cur) {
+        while (cur != nullptr && cur->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pool_state *next = cur->forward.load(std::memory_order_relaxed);
+            while (cur->chunks != nullptr) {
+                chunk_header *header = reinterpret_cast<chunk_header *>(cur->chunks);
+                Node *chunk = cur->chunks;
+                cur->chunks = header->next;
+                allocator_traits::deallocate(get_allocator(), chunk, header->capacity + 1);
+            }
+            state_allocator alloc(get_allocator());
+            state_traits::destroy(alloc, cur);
+            state_traits::deallocate(alloc, cur, 1);
+            // A merged state holds a reference to the state it forwards to
+            cur = next;
+        }
+    }
+    /**
+     * @brief move the chunks and free nodes of the source state into the target one, and forward the source to it.
+     * Both states should be locked.
+     *
+     * @param target
+     * @param source
+     */
+    static void absorb(pool_state *target, pool_state *source) {
+        if (source->free_list != nullptr) {
+            source->free_tail->next = target->free_list;
+            if (target->free_list == nullptr)
+                target->free_tail = source->free_tail;
+            target->free_list = source->free_list;
+        }
+        if (source->chunks != nullptr) {
+            reinterpret_cast<chunk_header *>(source->chunks_tail)->next = target->chunks;
+            if (target->chunks == nullptr)
+                target->chunks_tail = source->chunks_tail;
+            target->chunks = source->chunks;
+        }
+        source->chunks = source->chunks_tail = nullptr;
+        source->free_list = source->free_tail = nullptr;
+        target->refs.fetch_add(1, std::memory_order_relaxed);
+        source->forward.store(target, std::memory_order_release);
+    }
+    /**
+     * @brief take the nodes given back by the other pools, or carve a new chunk if there's none
+     *
+     */
+    void refill() {
+        std::unique_lock<std::mutex> guard = lock_state();
+        if (state->free_list != nullptr) {
+            free_list = state->free_list;
+            free_tail = state->free_tail;
+            state->free_list = state->free_tail = nullptr;
+            return;
+        }
+        Node *res = &*allocator_traits::allocate(get_allocator(), next_capacity + 1);
+        chunk_header *header = reinterpret_cast<chunk_header *>(res);
+        header->next = state->chunks;
+        header->capacity = next_capacity;
+        if (state->chunks == nullptr)
+            state->chunks_tail = res;
+        state->chunks = res;
+        cursor = res + 1;
+        limit = res + 1 + next_capacity;
+        if (next_capacity < MAX_CHUNK)
+            next_capacity <<= 1;
+    }
+    /**
+     * @brief give the free nodes and the unused part of the latest chunk back to the state, for the other pools
+     *
+     */
+    void give_back() {
+        while (cursor != limit)
+            deallocate(cursor++);
+        if (free_list == nullptr)
+            return;
+        std::unique_lock<std::mutex> guard = lock_state();
+        free_tail->next = state->free_list;
+        if (state->free_list == nullptr)
+            state->free_tail = free_tail;
+        state->free_list = free_list;
+        free_list = free_tail = nullptr;
+    }
+};
+
+/**
+ * @brief the compile-time options of the tree
+ *
+ * @tparam OrderStatistics whether every node keeps the size of its subtree, which is required by rank queries.
+ * Otherwise the tree saves the field, and doesn't walk back to the root to update it on every insertion and deletion.
+ * @tparam Threaded whether every node links to its predecessor and successor, so that stepping an iterator is a single
+ * pointer chase instead of a walk through the parents, at the cost of two more pointers per node.
+ */
+template <bool OrderStatistics = false, bool Threaded = false> struct tree_policy {
+    static constexpr bool order_statistics = OrderStatistics;
+    static constexpr bool threaded = Threaded;
+};
+
+/**
+ * @brief the color of a tree node, and the size of its subtree which only exists with order statistics enabled.
+ * They are put together at the head of the node, so that they share a word without padding in between.
+ *
+ */
+template <class Color, bool OrderStatistics> struct node_meta {
+    Color col;
+    node_meta(Color _col, int) : col(_col) {}
+};
+template <class Color> struct node_meta<Color, true> {
+    Color col;
+    int siz;
+    node_meta(Color _col, int _siz) : col(_col), siz(_siz) {}
+};
+
+/**
+ * @brief the links of a tree node to its neighbours in order, which only exist in a threaded tree.
+ * Rotations don't change the order, so only linking and unlinking a node touch them.
+ *
+ */
+template <class Node, bool Threaded> struct node_thread {};
+template <class Node> struct node_thread<Node, true> {
+    Node *pred, *succ;
+    node_thread() : pred(nullptr), succ(nullptr) {}
+};
+
+template <class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>,
+          class Policy = tree_policy<>>
+class RBTree : private compare_holder<Compare> {
   public:
     /**
      * the internal type of data.
@@ -26,28 +482,201 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
      *
      */
     enum color { BLACK, RED };
-    struct tnode {
+    static constexpr bool order_statistics = Policy::order_statistics;
+    static constexpr bool threaded = Policy::threaded;
+    struct tnode : node_meta<color, order_statistics>, node_thread<tnode, threaded> {
         value_type data;
         tnode *left, *right, *parent;
-        color col;
-        int siz;
 
-        tnode(const value_type &_data, tnode *_parent, color _col, int _siz = 0)
-            : data(_data), left(nullptr), right(nullptr), parent(_parent), col(_col), siz(_siz) {}
+        template <class... Args>
+        tnode(tnode *_parent, color _col, int _siz, Args &&...args)
+            : node_meta<color, order_statistics>(_col, _siz), data(std::forward<Args>(args)...), left(nullptr),
+              right(nullptr), parent(_parent) {}
     } * rt;
 
+  private:
+    using pool_type = node_pool<tnode, Allocator>;
+    using node_allocator = typename pool_type::allocator_type;
+    using node_traits = typename pool_type::allocator_traits;
+
+  protected:
+    /**
+     * @brief whether comparing a with b gives a three-way result in a single call,
+     *   either from a three-way Compare or from the compare() member of the keys
+     */
+    template <class A, class B>
+    static constexpr bool three_way_keys = is_three_way_compare<Compare>::value || has_compare_member<Compare, A, B>::value;
+
+    /**
+     * @brief the number of searches find_batch() runs at once, enough to keep the memory busy
+     */
+    static constexpr size_t batch_width = 32;
+
+    /**
+     * @brief whether a < b under Compare
+     */
+    template <class A, class B> bool key_less(const A &a, const B &b) const {
+        if constexpr (is_three_way_compare<Compare>::value)
+            return this->comparator()(a, b) < 0;
+        else
+            return this->comparator()(a, b);
+    }
+
+    /**
+     * @brief compare a with b
+     * It costs a single comparison if three_way_keys<A, B>, and two otherwise.
+     *
+     * @return a negative number if a < b, zero if a = b, and a positive number if a > b
+     */
+    template <class A, class B> int key_compare(const A &a, const B &b) const {
+        if constexpr (is_three_way_compare<Compare>::value) {
+            auto comp = this->comparator()(a, b);
+            return comp < 0 ? -1 : (comp > 0);
+        } else if constexpr (has_compare_member<Compare, A, B>::value) {
+            auto comp = a.compare(b);
+            return comp < 0 ? -1 : (comp > 0);
+        } else {
+            return this->comparator()(b, a) - this->comparator()(a, b);
+        }
+    }
+
   public:
-    RBTree() { rt = nullptr; }
-    RBTree(const RBTree<Key, T, Compare> &other) { rt = node_copy(other.rt); }
+    typedef Allocator allocator_type;
+
+    /**
+     * @brief a node taken out of a tree, which can be inserted into another tree without copying the element.
+     * It shares the chunks of the tree it comes from, so it may outlive that tree.
+     *
+     */
+    class node_handle {
+        friend class RBTree;
+
+      public:
+        typedef Key key_type;
+        typedef T mapped_type;
+        typedef Allocator allocator_type;
+
+        node_handle() : node(nullptr) {}
+        node_handle(node_handle &&other) noexcept : node(other.node), pool(std::move(other.pool)) {
+            other.node = nullptr;
+            other.pool.reset();
+        }
+        // Like a std node handle, the emptied handle takes the allocator of other along with its node.
+        node_handle &operator=(node_handle &&other) noexcept {
+            if (this == &other)
+                return *this;
+            reset();
+            if (other.pool)
+                pool.emplace(std::move(*other.pool));
+            node = other.node;
+            other.node = nullptr;
+            other.pool.reset();
+            return *this;
+        }
+        ~node_handle() { reset(); }
+
+        bool empty() const { return node == nullptr; }
+        explicit operator bool() const { return node != nullptr; }
+        // Notice: an empty handle has no allocator
+        allocator_type get_allocator() const { return allocator_type(pool->get_allocator()); }
+        // The key can be changed before the node is inserted again
+        Key &key() const { return const_cast<Key &>(node->data.first); }
+        T &mapped() const { return node->data.second; }
+
+      private:
+        tnode *node;
+        // The pool exists only while the handle owns a node, so that an empty handle needs no allocator
+        std::optional<pool_type> pool;
+
+        // The handle joins the chunks of the tree in O(1), so that a dropped node is given back for the tree to reuse
+        node_handle(tnode *_node, pool_type &_pool) : node(_node), pool(std::in_place, _pool.get_allocator()) {
+            pool->share(_pool);
+        }
+        void reset() {
+            if (node != nullptr) {
+                node_traits::destroy(pool->get_allocator(), node);
+                pool->deallocate(node);
+                node = nullptr;
+            }
+            pool.reset();
+        }
+    };
+
+    RBTree() : rt(nullptr), node_count(0), leftmost(nullptr), rightmost(nullptr) {}
+    explicit RBTree(const Allocator &alloc)
+        : rt(nullptr), node_count(0), leftmost(nullptr), rightmost(nullptr), pool(node_allocator(alloc)) {}
+    explicit RBTree(const Compare &comp, const Allocator &alloc = Allocator())
+        : compare_holder<Compare>(comp), rt(nullptr), node_count(0), leftmost(nullptr), rightmost(nullptr),
+          pool(node_allocator(alloc)) {}
+    RBTree(const RBTree<Key, T, Compare, Allocator, Policy> &other)
+        : compare_holder<Compare>(other), rt(nullptr), node_count(0), leftmost(nullptr), rightmost(nullptr),
+          pool(node_traits::select_on_container_copy_construction(other.pool.get_allocator())) {
+        rt = node_copy(other.rt);
+        node_count = other.node_count;
+        bounds_reset();
+        thread_reset();
+    }
 
     RBTree &operator=(const RBTree &other) {
         if (this == &other)
             return *this;
+        clear();
+        compare_holder<Compare>::operator=(other);
+        if constexpr (node_traits::propagate_on_container_copy_assignment::value)
+            pool.reset_allocator(other.pool.get_allocator());
         rt = node_copy(other.rt);
+        node_count = other.node_count;
+        bounds_reset();
+        thread_reset();
+        return *this;
+    }
+
+    // The comparator is copied, so that the moved-from tree stays usable
+    RBTree(RBTree &&other) noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+        : compare_holder<Compare>(other), rt(other.rt), node_count(other.node_count), leftmost(other.leftmost),
+          rightmost(other.rightmost), pool(std::move(other.pool)) {
+        other.rt = other.leftmost = other.rightmost = nullptr;
+        other.node_count = 0;
+    }
+
+    RBTree &operator=(RBTree &&other) {
+        if (this == &other)
+            return *this;
+        clear();
+        compare_holder<Compare>::operator=(other);
+        if (node_traits::propagate_on_container_move_assignment::value ||
+            pool.get_allocator() == other.pool.get_allocator()) {
+            pool = std::move(other.pool);
+            rt = other.rt;
+            node_count = other.node_count;
+            leftmost = other.leftmost;
+            rightmost = other.rightmost;
+            other.rt = other.leftmost = other.rightmost = nullptr;
+            other.node_count = 0;
+        } else {
+            // The nodes cannot move between different allocators, so move the elements instead
+            for (tnode *cur = other.first(); cur != nullptr; cur = other.next(cur))
+                insert(std::move(cur->data));
+            other.clear();
+        }
         return *this;
     }
 
-    ~RBTree() { node_destruct(rt); }
+    ~RBTree() { node_destruct_all(); }
+
+    /**
+     * @brief returns the allocator associated with the container
+     *
+     * @return Allocator
+     */
+    Allocator get_allocator() const { return Allocator(pool.get_allocator()); }
+
+    /**
+     * @brief returns the function object that compares the keys
+     *
+     * @return Compare
+     */
+    Compare key_comp() const { return this->comparator(); }
 
   public:
     /**
@@ -56,82 +685,351 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
      * @return true if empty
      * @return false otherwise
      */
-    bool empty() { return rt == nullptr; }
+    bool empty() const { return rt == nullptr; }
     /**
      * @brief returns the number of elements.
      *
      * @return size_t
      */
-    size_t size() const { return rt ? rt->siz : 0; }
+    size_t size() const { return node_count; }
+    /**
+     * @brief clear the contents, and return the memory of nodes to the system
+     *
+     */
+    void clear() {
+        node_destruct_all();
+        node_count = 0;
+        leftmost = rightmost = nullptr;
+        pool.release();
+    }
     /**
-     * @brief clear the contents
+     * @brief replace the contents with the elements in [first, last).
+     *   If the keys are ascending, a balanced tree is built in O(n), with the nodes laid out in order in memory,
+     *   and only the first of the equal keys is kept. Otherwise the elements are inserted one by one.
      *
+     * @param first
+     * @param last
      */
-    void clear() { node_destruct(rt); }
+    template <class ForwardIt> void assign_sorted(ForwardIt first, ForwardIt last) {
+        clear();
+        size_t count = 0;
+        bool sorted = true;
+        for (ForwardIt prev = first, cur = first; cur != last && sorted; prev = cur++) {
+            if (cur == first || key_less((*prev).first, (*cur).first))
+                count++;
+            else
+                sorted = !key_less((*cur).first, (*prev).first);
+        }
+        if (!sorted) {
+            for (; first != last; ++first)
+                insert(*first);
+            return;
+        }
+        // The nodes on the deepest level are red, so that all the paths have the same number of black nodes
+        int red_depth = 0;
+        while ((size_t(2) << red_depth) <= count)
+            red_depth++;
+        rt = build_sorted(first, last, count, 0, red_depth == 0 ? -1 : red_depth);
+        node_count = count;
+        bounds_reset();
+        thread_reset();
+    }
 
   public:
-    tnode *find(const Key &key) const {
+    /**
+     * @brief find the node with the selected key.
+     * The lookups accept any type K that Compare can compare with Key, which only makes sense for a transparent Compare.
+     *
+     * @param key
+     * @return nullptr if there's no such node
+     */
+    template <class K> tnode *find(const K &key) const {
+        // Without a three-way comparison, it's cheaper to compare once on each level like lower_bound(),
+        // and check the equality only at the end
+        if constexpr (!three_way_keys<K, Key>) {
+            tnode *res = lower_bound(key);
+            return res != nullptr && !key_less(key, res->data.first) ? res : nullptr;
+        }
         tnode *cur = rt;
         while (cur != nullptr) {
-            /**
-             * if key < cur->key, comp = 0 - 1 = -1
-             * if key = cur->key, comp = 0 - 0 = 0
-             * if key > cur->key, comp = 1 - 0 = 1
-             * (same below)
-             */
-            int comp = Compare()(cur->data.first, key) - Compare()(key, cur->data.first);
+            int comp = key_compare(key, cur->data.first);
             if (!comp)
                 break;
-            if (comp < 0)
-                cur = cur->left;
-            else
-                cur = cur->right;
+            cur = comp < 0 ? cur->left : cur->right;
         }
         return cur;
     }
 
-    tnode *first() const {
-        tnode *u = rt;
-        if (u == nullptr)
-            return nullptr;
-        while (u->left != nullptr)
-            u = u->left;
-        return u;
+    /**
+     * @brief find the first node whose key is not less than the selected key.
+     * It only compares once on each level, remembering the last node on the path that may be the answer.
+     *
+     * @param key
+     * @return nullptr if there's no such node
+     */
+    template <class K> tnode *lower_bound(const K &key) const {
+        tnode *cur = rt, *res = nullptr;
+        while (cur != nullptr) {
+            if (key_less(cur->data.first, key)) {
+                cur = cur->right;
+            } else {
+                res = cur;
+                cur = cur->left;
+            }
+        }
+        return res;
     }
 
-    tnode *last() const {
-        tnode *u = rt;
-        if (u == nullptr)
-            return nullptr;
-        while (u->right != nullptr)
-            u = u->right;
-        return u;
+    /**
+     * @brief find the first node whose key is greater than the selected key, in the same way as lower_bound()
+     *
+     * @param key
+     * @return nullptr if there's no such node
+     */
+    template <class K> tnode *upper_bound(const K &key) const {
+        tnode *cur = rt, *res = nullptr;
+        while (cur != nullptr) {
+            if (key_less(key, cur->data.first)) {
+                res = cur;
+                cur = cur->left;
+            } else {
+                cur = cur->right;
+            }
+        }
+        return res;
     }
 
-    tnode *prev(tnode *ptr) const {
-        if (ptr->left) {
-            ptr = ptr->left;
-            while (ptr->right != nullptr)
-                ptr = ptr->right;
+    /**
+     * @brief find the first node whose key is not less than the selected key, starting from the finger.
+     *   It climbs from the finger only until the key is known to lie in the subtree beside the path,
+     *   comparing once on each turn of it, and then descends that subtree like lower_bound().
+     *   A key close to the finger is thus found after O(log d) steps in most cases, where d is their distance in order.
+     *
+     * @param finger the node to start from, or nullptr for the end
+     * @param key
+     * @return nullptr if there's no such node
+     */
+    template <class K> tnode *lower_bound(tnode *finger, const K &key) const {
+        tnode *cur = finger == nullptr ? last() : finger, *res = nullptr;
+        if (cur == nullptr)
+            return nullptr;
+        if (key_less(cur->data.first, key)) {
+            // The keys between cur and the nearest ancestor greater than it are in the right subtree of cur
+            while (true) {
+                tnode *above = cur;
+                while (above->parent != nullptr && above->parent->right == above)
+                    above = above->parent;
+                above = above->parent;
+                if (above == nullptr || !key_less(above->data.first, key)) {
+                    res = above;
+                    cur = cur->right;
+                    break;
+                }
+                cur = above;
+            }
         } else {
-            while (ptr != rt && is_left(ptr))
-                ptr = ptr->parent;
-            if (ptr->parent == nullptr)
-                throw invalid_iterator();
-            ptr = ptr->parent;
+            // The keys between the nearest ancestor less than cur and cur are in the left subtree of cur
+            while (true) {
+                tnode *below = cur;
+                while (below->parent != nullptr && below->parent->left == below)
+                    below = below->parent;
+                below = below->parent;
+                if (below == nullptr || key_less(below->data.first, key)) {
+                    res = cur;
+                    cur = cur->left;
+                    break;
+                }
+                cur = below;
+            }
         }
-        return ptr;
+        while (cur != nullptr) {
+            if (key_less(cur->data.first, key)) {
+                cur = cur->right;
+            } else {
+                res = cur;
+                cur = cur->left;
+            }
+        }
+        return res;
     }
 
-    tnode *next(tnode *ptr) const {
-        if (ptr == nullptr)
-            throw invalid_iterator();
-        if (ptr->right) {
-            ptr = ptr->right;
-            while (ptr->left != nullptr)
-                ptr = ptr->left;
+    /**
+     * @brief find the node with the selected key, starting from the finger like lower_bound(finger, key)
+     *
+     * @param finger the node to start from, or nullptr for the end
+     * @param key
+     * @return nullptr if there's no such node
+     */
+    template <class K> tnode *find(tnode *finger, const K &key) const {
+        tnode *res = lower_bound(finger, key);
+        return res != nullptr && !key_less(key, res->data.first) ? res : nullptr;
+    }
+
+    /**
+     * @brief find the nodes with many keys at once.
+     *   Up to batch_width searches run interleaved, each taking one level in turn and prefetching its next node,
+     *   so that their cache misses overlap instead of each level waiting for the last one.
+     *   A finished search gives its slot to the next key right away.
+     *
+     * @param keys
+     * @param n the number of keys
+     * @param report called as report(i, node) once the search for keys[i] finishes, with nullptr if there's no such node
+     */
+    template <class K, class Report> void find_batch(const K *keys, size_t n, Report report) const {
+        struct lookup {
+            size_t index;
+            tnode *cur, *res;
+        };
+        if (rt == nullptr) {
+            for (size_t i = 0; i < n; i++)
+                report(i, nullptr);
+            return;
+        }
+        lookup slots[batch_width];
+        size_t started = 0, active = 0;
+        while (active < batch_width && started < n)
+            slots[active++] = {started++, rt, nullptr};
+        while (active > 0) {
+            for (size_t i = 0; i < active;) {
+                lookup &slot = slots[i];
+                if (slot.cur == nullptr) {
+                    const K &key = keys[slot.index];
+                    report(slot.index, slot.res != nullptr && !key_less(key, slot.res->data.first) ? slot.res : nullptr);
+                    if (started == n) {
+                        slot = slots[--active];
+                        continue;
+                    }
+                    slot = {started++, rt, nullptr};
+                }
+                // The same step as lower_bound()
+                if (key_less(slot.cur->data.first, keys[slot.index])) {
+                    slot.cur = slot.cur->right;
+                } else {
+                    slot.res = slot.cur;
+                    slot.cur = slot.cur->left;
+                }
+                prefetch(slot.cur);
+                i++;
+            }
+        }
+    }
+
+    /**
+     * @brief the smallest node, in O(1)
+     *
+     * @return nullptr if the tree is empty
+     */
+    tnode *first() const { return leftmost; }
+    /**
+     * @brief the largest node, in O(1)
+     *
+     * @return nullptr if the tree is empty
+     */
+    tnode *last() const { return rightmost; }
+
+    /**
+     * @brief find the k-th (0-based) node in order by the subtree sizes, with order statistics enabled
+     *
+     * @param k
+     * @return nullptr if k >= size()
+     */
+    tnode *select(size_t k) const {
+        tnode *cur = rt;
+        while (cur != nullptr) {
+            size_t left_size = subtree_size(cur->left);
+            if (k == left_size)
+                break;
+            if (k < left_size) {
+                cur = cur->left;
+            } else {
+                k -= left_size + 1;
+                cur = cur->right;
+            }
+        }
+        return cur;
+    }
+
+    /**
+     * @brief count the nodes before the selected one, with order statistics enabled
+     *
+     * @param cur
+     * @return size() if cur is nullptr
+     */
+    size_t node_rank(const tnode *cur) const {
+        if (cur == nullptr)
+            return node_count;
+        size_t res = subtree_size(cur->left);
+        for (; cur->parent != nullptr; cur = cur->parent)
+            if (cur->parent->right == cur)
+                res += subtree_size(cur->parent->left) + 1;
+        return res;
+    }
+
+    /**
+     * @brief count the keys less than the selected key, with order statistics enabled
+     *
+     * @param key
+     * @return size_t
+     */
+    size_t key_rank(const Key &key) const {
+        tnode *cur = rt;
+        size_t res = 0;
+        while (cur != nullptr) {
+            if (key_less(cur->data.first, key)) {
+                res += subtree_size(cur->left) + 1;
+                cur = cur->right;
+            } else {
+                cur = cur->left;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief the previous node in order, which is a single link in a threaded tree
+     * @throw invalid_iterator if ptr is the first node
+     *
+     * @param ptr
+     * @return tnode*
+     */
+    tnode *prev(tnode *ptr) const {
+        if constexpr (threaded) {
+            if (ptr->pred == nullptr)
+                throw invalid_iterator();
+            return ptr->pred;
+        }
+        if (ptr->left) {
+            ptr = ptr->left;
+            while (ptr->right != nullptr)
+                ptr = ptr->right;
         } else {
-            while (ptr != rt && !is_left(ptr))
+            while (ptr->parent != nullptr && ptr->parent->left == ptr)
+                ptr = ptr->parent;
+            if (ptr->parent == nullptr)
+                throw invalid_iterator();
+            ptr = ptr->parent;
+        }
+        return ptr;
+    }
+
+    /**
+     * @brief the next node in order, which is a single link in a threaded tree
+     * @throw invalid_iterator if ptr is nullptr (the end)
+     *
+     * @param ptr
+     * @return nullptr if ptr is the last node
+     */
+    tnode *next(tnode *ptr) const {
+        if (ptr == nullptr)
+            throw invalid_iterator();
+        if constexpr (threaded)
+            return ptr->succ;
+        if (ptr->right) {
+            ptr = ptr->right;
+            while (ptr->left != nullptr)
+                ptr = ptr->left;
+        } else {
+            while (ptr->parent != nullptr && ptr->parent->right == ptr)
                 ptr = ptr->parent;
             ptr = ptr->parent;
         }
@@ -139,19 +1037,34 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
     }
 
   public:
-    pair<tnode *, bool> insert(const value_type &value) {
+    pair<tnode *, bool> insert(const value_type &value) { return insert_value(value); }
+    pair<tnode *, bool> insert(value_type &&value) { return insert_value(std::move(value)); }
+
+  private:
+    template <class V> pair<tnode *, bool> insert_value(V &&value) {
         tnode *cur = rt, *next;
         if (cur == nullptr) { // If the tree is empty
             // Create a new root node, with col = RED, size = 1 and no links to other node
-            rt = cur = new tnode(value, nullptr, BLACK, 1);
+            rt = leftmost = rightmost = cur = node_create(nullptr, BLACK, 1, std::forward<V>(value));
+            node_count++;
             return {cur, true};
         }
+        // Without a three-way comparison, we compare once on each level, treating an equal key as a greater one,
+        // and remember the last node we went left at, which is the only node that may have the same key
+        tnode *same = nullptr;
         // Here we try to ensure the node we found cannot have a red sibling,
         // which requires that every node on the path doesn't have two red descendants.
         while (true) {
-            int comp = Compare()(cur->data.first, value.first) - Compare()(value.first, cur->data.first);
-            if (!comp) // Find the same element
-                return {cur, false};
+            int comp;
+            if constexpr (three_way_keys<Key, Key>) {
+                comp = key_compare(value.first, cur->data.first);
+                if (!comp) // Find the same element
+                    return {cur, false};
+            } else {
+                comp = key_less(cur->data.first, value.first) ? 1 : -1;
+                if (comp < 0)
+                    same = cur;
+            }
             // If the current node has two red descendeants, we should change them to black.
             if ((cur->left && cur->left->col == RED) && (cur->right && cur->right->col == RED)) {
                 cur->col = RED;
@@ -159,20 +1072,17 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
                 // fix the situation if there's a red-red link to its parent.
                 insert_adjust(cur);
             }
-            if (comp < 0) {
-                if (cur->left == nullptr) {
-                    cur = cur->left = new tnode(value, cur, RED);
-                    break;
-                }
-                cur = cur->left;
-            } else {
-                if (cur->right == nullptr) {
-                    cur = cur->right = new tnode(value, cur, RED);
-                    break;
-                }
-                cur = cur->right;
+            tnode *&child = comp < 0 ? cur->left : cur->right;
+            if (child == nullptr) {
+                if (same != nullptr && !key_less(value.first, same->data.first)) // Find the same element
+                    return {same, false};
+                cur = child = node_create(cur, RED, 0, std::forward<V>(value));
+                bounds_link(cur);
+                break;
             }
+            cur = child;
         }
+        node_count++;
         // Change the size backward
         size_adjust_upward(cur, 1);
         // After inserted, fix the red-red link again
@@ -180,43 +1090,218 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
         return {cur, true};
     }
 
+  public:
+    /**
+     * @brief insert the element next to the hint if it belongs there, with at most two comparisons,
+     *   or search from the root otherwise
+     *
+     * @param hint the node the element should be inserted beside, or nullptr for the end
+     * @param value
+     * @return the element with the key, and whether it's newly inserted
+     */
+    pair<tnode *, bool> insert(tnode *hint, const value_type &value) {
+        if (rt == nullptr)
+            return insert(value);
+        return node_place(search(hint, value.first), value);
+    }
+    pair<tnode *, bool> insert(tnode *hint, value_type &&value) {
+        if (rt == nullptr)
+            return insert(std::move(value));
+        return node_place(search(hint, value.first), std::move(value));
+    }
+    /**
+     * @brief construct an element from args and insert it, which has to construct the node before searching
+     *
+     * @param args
+     * @return the element with the key, and whether it's newly inserted
+     */
+    template <class... Args> pair<tnode *, bool> emplace(Args &&...args) {
+        return node_insert(node_create(nullptr, RED, 1, std::forward<Args>(args)...), nullptr, false);
+    }
+    /**
+     * @brief construct an element from args and insert it beside the hint, like insert(hint, value)
+     *
+     * @param hint
+     * @param args
+     * @return the element with the key, and whether it's newly inserted
+     */
+    template <class... Args> pair<tnode *, bool> emplace_hint(tnode *hint, Args &&...args) {
+        return node_insert(node_create(nullptr, RED, 1, std::forward<Args>(args)...), hint, true);
+    }
+    /**
+     * @brief insert an element with the key and the value constructed from args, if the key doesn't exist.
+     *   Nothing is constructed if it does.
+     *
+     * @param key a const Key & or a Key &&, which is moved into the element only if it's inserted
+     * @param args
+     * @return the element with the key, and whether it's newly inserted
+     */
+    template <class K, class... Args> pair<tnode *, bool> try_emplace(K &&key, Args &&...args) {
+        return node_place(search(key), std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @brief erase the element with the key, if there's one.
+     * It finds the node with one comparison on each level, and unlinks it bottom-up by erase_node().
+     *
+     * @param key
+     */
     void erase(const Key &key) {
-        if (!Compare()(rt->data.first, key) && !Compare()(rt->data.first, key) && rt->left == nullptr && rt->right == nullptr) {
-            delete rt;
-            rt = nullptr;
+        tnode *cur = find(key);
+        if (cur != nullptr)
+            erase_node(cur);
+    }
+
+    /**
+     * @brief move the elements not less than key into another (empty) tree, in O(log n).
+     * The two trees share the chunks of nodes afterwards, so the nodes are moved without copying.
+     * Without order statistics, the moved elements have to be counted, which takes O(k) more.
+     *
+     * @param key
+     * @param other
+     */
+    void split(const Key &key, RBTree &other) {
+        other.clear();
+        if (rt == nullptr)
+            return;
+        if (!other.pool.share(pool)) {
+            // The nodes cannot move between different allocators, so move the elements instead
+            for (tnode *cur = lower_bound(key), *next_node; cur != nullptr; cur = next_node) {
+                next_node = next(cur);
+                other.insert(std::move(cur->data));
+                erase_node(cur);
+            }
             return;
         }
-        tnode *cur = rt;
-        // Here we try to ensure every node we met is red, which then conducts the node we want to delete is red
-        while (true) {
-            if (cur == nullptr)
-                return;
-            // Change the current node to red
-            erase_adjust(cur, key);
-            int comp = Compare()(cur->data.first, key) - Compare()(key, cur->data.first);
-            // If we find the node with two descendents,
-            // swap the data with its 'next' node and delete that node then
-            if (!comp && cur->left != nullptr && cur->right != nullptr) {
-                tnode *next = cur->right;
-                while (next->left)
-                    next = next->left;
-                node_swap(cur, next);
-                cur = next->right;
+        other.rt = split_off(key);
+        other.node_count = other.rt == nullptr ? 0 : (order_statistics ? subtree_size(other.rt) : node_count_of(other.rt));
+        node_count -= other.node_count;
+        bounds_reset();
+        other.bounds_reset();
+        thread_join(rightmost, nullptr);
+        thread_join(nullptr, other.leftmost);
+    }
+    /**
+     * @brief move all the elements of another tree into this one, in O(log n),
+     *   if the keys of one tree are all less than those of the other.
+     * @throw runtime_error if the key ranges of the two trees overlap
+     *
+     * @param other
+     */
+    void join(RBTree &other) {
+        if (this == &other || other.rt == nullptr)
+            return;
+        bool less = rt == nullptr || key_less(last()->data.first, other.first()->data.first);
+        if (!less && !key_less(other.last()->data.first, first()->data.first))
+            throw runtime_error();
+        if (!pool.share(other.pool)) {
+            // The nodes cannot move between different allocators, so move the elements instead
+            for (tnode *cur = other.first(); cur != nullptr; cur = other.next(cur))
+                insert(std::move(cur->data));
+            other.clear();
+            return;
+        }
+        if (rt != nullptr) {
+            if (less)
+                thread_join(last(), other.first());
+            else
+                thread_join(other.last(), first());
+            rt = less ? join_trees(rt, other.rt) : join_trees(other.rt, rt);
+            node_count += other.node_count;
+        } else {
+            rt = other.rt;
+            node_count = other.node_count;
+        }
+        bounds_reset();
+        other.rt = other.leftmost = other.rightmost = nullptr;
+        other.node_count = 0;
+    }
+    /**
+     * @brief erase the elements in [lo, hi), by cutting them off as a whole subtree in O(log n),
+     *   and destructing the nodes in O(k).
+     *
+     * @param lo
+     * @param hi
+     * @return the number of elements erased
+     */
+    size_t erase_range(const Key &lo, const Key &hi) { return key_less(lo, hi) ? erase_between(lo, &hi) : 0; }
+    /**
+     * @brief erase the elements not less than lo, in the same way as erase_range()
+     *
+     * @param lo
+     * @return the number of elements erased
+     */
+    size_t erase_from(const Key &lo) { return erase_between(lo, nullptr); }
+    /**
+     * @brief erase the selected node, rebalancing from bottom up without any comparison
+     *
+     * @param cur
+     */
+    void erase_node(tnode *cur) {
+        node_unlink(cur);
+        node_delete(cur);
+    }
+    /**
+     * @brief unlink the selected node from the tree, and hand it over without destructing it.
+     *   The handle joins the chunks of the tree without allocating, and takes O(1) more than the unlinking.
+     *
+     * @param cur
+     * @return node_handle
+     */
+    node_handle extract(tnode *cur) {
+        node_handle res(cur, pool);
+        node_unlink(cur);
+        return res;
+    }
+    /**
+     * @brief link the node of a handle into the tree, if its key doesn't exist.
+     *   The node is moved without copying if the allocators are equal.
+     *
+     * @param handle which is left empty if the node is inserted
+     * @return the element with the key, and whether it's newly inserted
+     */
+    pair<tnode *, bool> insert(node_handle &&handle) {
+        if (handle.empty())
+            return {nullptr, false};
+        pair<tnode *, int> pos = search(handle.node->data.first);
+        if (pos.first != nullptr && pos.second == 0)
+            return {pos.first, false};
+        tnode *cur = handle.node;
+        if (pool.share(*handle.pool)) {
+            handle.node = nullptr;
+            handle.reset();
+        } else {
+            cur = node_create(nullptr, RED, 1, std::move(cur->data));
+            handle.reset();
+        }
+        return node_insert(cur, pos);
+    }
+    /**
+     * @brief move the elements of other whose keys don't exist in this tree, by relinking their nodes
+     *
+     * @param other
+     */
+    void merge(RBTree &other) {
+        if (this == &other || other.rt == nullptr)
+            return;
+        // The chunks of other are shared only once a node moves, so that other keeps them to itself otherwise
+        bool movable = pool.get_allocator() == other.pool.get_allocator(), shared = false;
+        for (tnode *cur = other.first(), *next; cur != nullptr; cur = next) {
+            next = other.next(cur);
+            pair<tnode *, int> pos = search(cur->data.first);
+            if (pos.first != nullptr && pos.second == 0)
                 continue;
+            if (movable && !shared)
+                shared = pool.share(other.pool);
+            if (shared) {
+                other.node_unlink(cur);
+                node_insert(cur, pos);
+            } else {
+                node_place(pos, std::move(cur->data));
+                other.node_unlink(cur);
+                other.node_delete(cur);
             }
-            // If we find the node
-            if (!comp) {
-                tnode *replacement = cur->left == nullptr ? cur->right : cur->left;
-                if (is_left(cur))
-                    cur->parent->left = replacement;
-                else
-                    cur->parent->right = replacement;
-                size_adjust_upward(cur, -1);
-                delete cur;
-                return;
-            }
-            // Go to the next node
-            cur = comp > 0 ? cur->right : cur->left;
         }
     }
 
@@ -234,12 +1319,27 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
         std::string msg;
     };
 
+    // the number of nodes, which is kept whether the nodes know their subtree sizes or not
+    size_t node_count;
+    // the smallest and the largest nodes, cached as the header of the tree so that begin() and --end() cost O(1).
+    // Linking and unlinking a node keep them, and the operations on whole subtrees recompute them by bounds_reset().
+    tnode *leftmost, *rightmost;
+
+    /**
+     * @brief get the size of a subtree, only meaningful with order statistics enabled
+     *
+     * @param cur
+     * @return int
+     */
+    static int subtree_size(const tnode *cur) {
+        if constexpr (order_statistics)
+            return cur ? cur->siz : 0;
+        else
+            return 0;
+    }
     void size_adjust(tnode *cur) {
-        cur->siz = 1;
-        if (cur->left != nullptr)
-            cur->siz += cur->left->siz;
-        if (cur->right != nullptr)
-            cur->siz += cur->right->siz;
+        if constexpr (order_statistics)
+            cur->siz = 1 + subtree_size(cur->left) + subtree_size(cur->right);
     }
     /**
      * @brief Adjust the size of the nodes upward
@@ -248,9 +1348,11 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
      * @param delta
      */
     void size_adjust_upward(tnode *cur, int delta) {
-        while (cur != nullptr) {
-            cur->siz += delta;
-            cur = cur->parent;
+        if constexpr (order_statistics) {
+            while (cur != nullptr) {
+                cur->siz += delta;
+                cur = cur->parent;
+            }
         }
     }
 
@@ -315,173 +1417,6 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
         }
     }
 
-    /**
-     * @brief Adjust every node on the path to red node
-     *
-     * @param cur
-     */
-    void erase_adjust(tnode *cur, Key del) {
-        // If the current node is red, we don't need to change it.
-        // Notice: it only happens when current node is root.
-        if (cur->col == RED)
-            return;
-        /**
-         * if del < cur->key, comp = 0 - 1 = -1
-         * if del = cur->key, comp = 0 - 0 = 0
-         * if del > cur->key, comp = 1 - 0 = 1
-         */
-        int comp = Compare()(cur->data.first, del) - Compare()(del, cur->data.first);
-        if (has_black_descendants(cur)) {
-            // note that sib == nullptr suggest it has no siblings or it's the root
-            tnode *sib = sibling(cur);
-            // If the (black) sibling node has two black descendants or it doesn't have a sibling
-            /** Case 1-1: cur (black, black, black), sib null or (black, black, black)
-             *  That would not change the structure of the tree
-             */
-            if (sib == nullptr || has_black_descendants(sib)) {
-                if (cur->parent)
-                    cur->parent->col = BLACK;
-                if (sib)
-                    sib->col = RED;
-                cur->col = RED;
-                return;
-            }
-            // If the current node has a sibling which has red descendent
-            /** Case 1-2: cur (black, black, black) at left, sib with outer red at right
-             *      R(par)                    B(sib)                 R(sib)
-             *     /   \                     /  \                   /   \
-             *    B(cur)B(sib) -------->  R(par) R2 -------->     B(par) B2
-             *           \               /                       /
-             *            R2            B(cur)                R(cur)
-             *  That is a left_rotate on par and change color then
-             */
-            if (is_left(cur) && sib->right && sib->right->col == RED) {
-                left_rotate(cur->parent);
-                sib->col = RED;
-                cur->parent->col = BLACK;
-                sib->right->col = BLACK;
-                cur->col = RED;
-                return;
-            }
-            /** Case 1-3: cur (black, black, black) at right, sib with outer red at left
-             *     R(par)                   B(sib)                 R(sib)
-             *    /    \                   /  \                   /  \
-             *   B(sib) B(cur) -------->  R1   R(par)  ------->  B1  B(par)
-             *  /                                \                     \
-             * R1                                 B(cur)                R(cur)
-             *  That is a right_rotate on par and change color then
-             */
-            if (!is_left(cur) && sib->left && sib->left->col == RED) {
-                right_rotate(cur->parent);
-                sib->col = RED;
-                sib->left->col = BLACK;
-                cur->parent->col = BLACK;
-                cur->col = RED;
-            }
-            /** Case 1-4: cur (black, black, black) at left, sib with inner red at left
-             *      R(par)                    R(par)                  R1                   R1
-             *     /    \                     /  \                   /  \                 /  \
-             *    B(cur) B(sib) -------->  B(cur) R1 -------->    R(par) B(sib) -----> B(par) B(sib)
-             *          /                          \             /                    /
-             *         R1                          B(sib)       B(cur)              R(cur)
-             *  That is a right_rotate on sib, left_rotate on par and change color then
-             */
-            if (is_left(cur) && sib->left && sib->left->col == RED) {
-                right_rotate(sib);
-                left_rotate(cur->parent);
-                std::swap(cur->col, cur->parent->col);
-            }
-            /** Case 1-5: cur (black, black, black) at right, sib with inner red at right
-             *      R(par)                      R(par)                 R1                   B1
-             *     /    \                      /  \                   /  \                 /  \
-             *    B(sib) B(cur) -------->    R1   B(cur) --------> B(sib) R(par) -----> B(sib) B(sib)
-             *     \                        /                               \                   \
-             *      R1                    B(sib)                           B(cur)                R(cur)
-             *  That is a left_rotate on sib, right_rotate on par and change color then
-             */
-            if (!is_left(cur) && sib->right && sib->right->col == RED) {
-                left_rotate(sib);
-                right_rotate(cur->parent);
-                std::swap(cur->col, cur->parent->col);
-            }
-        } else {
-            // If the current node is the node to be deleted
-            if (!comp) {
-                // If the current node has two descendents
-                if (cur->left && cur->right) {
-                    // If the right descendent is black
-                    /** Case 2-1: cur (black, red, black), which implies that left node has two black descendents
-                     *     B(cur)      R1         B1
-                     *    /     ----->  \  ----->  \
-                     *   R1              B(cur)    R(cur)
-                     */
-                    if (cur->right->col == BLACK) {
-                        right_rotate(cur);
-                        std::swap(cur->col, cur->parent->col);
-                    }
-                    /** Case 2-2: cur (black, black, red), we'll reach its right node then, so don't need to change anything
-                     */
-                    else
-                        ;
-                    return;
-                }
-                /** Case 2-2: cur (black, red, null)
-                 *    B(cur)     R1           B1
-                 *   /    ----->  \   ------>  \
-                 *  R1             B(cur)      R(cur)
-                 */
-                if (cur->left) {
-                    right_rotate(cur);
-                    std::swap(cur->col, cur->parent->col);
-                }
-                /** Case 2-3: cur (black, null, red)
-                 *   B(cur)        R1          B1
-                 *    \    -----> /    -----> /
-                 *    R1         B(cur)      R(cur)
-                 */
-                if (cur->right) {
-                    left_rotate(cur);
-                    std::swap(cur->col, cur->parent->col);
-                    return;
-                }
-            }
-            // If the current node isn't the node to be deleted
-            else {
-                /** Case 2-3: we'll reach a red node or nullptr then, so don't need to change anything
-                 */
-                if ((comp < 0 && (!cur->left || cur->left->col == RED)) ||
-                    (comp > 0 && (!cur->right || cur->right->col == RED)))
-                    return;
-                /** Case 2-4: cur (black, black, red) and we'll reach its left node then
-                 *      B(cur)          R2              B2
-                 *     / \              /              /
-                 *    B1 R2    -----> B(cur) ----->   R(cur)
-                 *                   /               /
-                 *                  B1              B1
-                 * That is a left_rotate on cur and change color then
-                 */
-                if (comp < 0 && cur->left->col == BLACK) {
-                    left_rotate(cur);
-                    std::swap(cur->col, cur->parent->col);
-                    return;
-                }
-                /** Case 2-5: cur (black, black, red) and we'll reach its left node then
-                 *      B(cur)       R1              B1
-                 *     / \            \               \
-                 *    R1 B2    ----->  B(cur) ----->   R(cur)
-                 *                      \               \
-                 *                      B2               B2
-                 * That is a left_rotate on cur and change color then
-                 */
-                if (comp > 0 && cur->right->col == BLACK) {
-                    right_rotate(cur);
-                    std::swap(cur->col, cur->parent->col);
-                    return;
-                }
-            }
-        }
-    }
-
     /**
      * @brief Rotate the selected node to its left child, with its right child replacing the current position
      *   cur              r0
@@ -516,39 +1451,706 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
     }
 
     /**
-     * @brief Rotate the selected node to its right child, with its left child replacing the current position
-     *      cur            l0
-     *     /  \           /  \
-     *    l0  r0  ---->  l1  cur
-     *   /  \               /  \
-     *  l1  r1             r1  r0
-     * @throw custom_exception when the selected node doesn't have a left child
+     * @brief Rotate the selected node to its right child, with its left child replacing the current position
+     *      cur            l0
+     *     /  \           /  \
+     *    l0  r0  ---->  l1  cur
+     *   /  \               /  \
+     *  l1  r1             r1  r0
+     * @throw custom_exception when the selected node doesn't have a left child
+     *
+     * @param cur
+     */
+    void right_rotate(tnode *cur) {
+        if (cur->left == nullptr)
+            throw custom_exception("The node to rotate (right) doesn't have a left child.");
+        if (cur->parent) {
+            if (is_left(cur))
+                cur->parent->left = cur->left;
+            else
+                cur->parent->right = cur->left;
+        } else {
+            rt = cur->left;
+        }
+        tnode *tmp = cur->left;
+        tmp->parent = cur->parent;
+        cur->left = tmp->right;
+        if (tmp->right)
+            tmp->right->parent = cur;
+        tmp->right = cur;
+        cur->parent = tmp;
+        size_adjust(cur);
+        size_adjust(tmp);
+    }
+
+    /**
+     * @brief Fix the red-red link between the selected (red) node and its parent from bottom up,
+     *   which may leave the root red
+     *
+     * @param cur
+     */
+    void insert_fixup(tnode *cur) {
+        while (cur->parent != nullptr && cur->parent->col == RED && cur->parent->parent != nullptr) {
+            tnode *par = cur->parent, *grand = par->parent;
+            tnode *uncle = par == grand->left ? grand->right : grand->left;
+            if (uncle != nullptr && uncle->col == RED) {
+                par->col = uncle->col = BLACK;
+                grand->col = RED;
+                cur = grand;
+                continue;
+            }
+            if (par == grand->left) {
+                if (cur == par->right) {
+                    left_rotate(par);
+                    par = cur;
+                }
+                right_rotate(grand);
+            } else {
+                if (cur == par->left) {
+                    right_rotate(par);
+                    par = cur;
+                }
+                left_rotate(grand);
+            }
+            par->col = BLACK;
+            grand->col = RED;
+            return;
+        }
+    }
+
+    /**
+     * @brief Link a standalone node as an empty child of the selected parent, and rebalance from bottom up
+     *
+     * @param par
+     * @param left whether the node is the left child
+     * @param cur
+     * @return the linked node
+     */
+    tnode *node_link(tnode *par, bool left, tnode *cur) {
+        cur->col = RED;
+        cur->parent = par;
+        size_adjust(cur);
+        (left ? par->left : par->right) = cur;
+        node_count++;
+        bounds_link(cur);
+        size_adjust_upward(par, 1);
+        insert_fixup(cur);
+        rt->col = BLACK;
+        return cur;
+    }
+
+    /**
+     * @brief Keep the bounds after linking a new leaf, which becomes a bound if it hangs outside the old one,
+     *   and thread the leaf next to its parent
+     *
+     * @param cur
+     */
+    void bounds_link(tnode *cur) {
+        tnode *par = cur->parent;
+        if (par == leftmost && par->left == cur)
+            leftmost = cur;
+        else if (par == rightmost && par->right == cur)
+            rightmost = cur;
+        if constexpr (threaded) {
+            // A left leaf comes right before its parent, and a right leaf right after it
+            if (par->left == cur) {
+                cur->succ = par, cur->pred = par->pred;
+                if (par->pred != nullptr)
+                    par->pred->succ = cur;
+                par->pred = cur;
+            } else {
+                cur->pred = par, cur->succ = par->succ;
+                if (par->succ != nullptr)
+                    par->succ->pred = cur;
+                par->succ = cur;
+            }
+        }
+    }
+
+    /**
+     * @brief Make b follow a in the threads, where either of them may be nullptr
+     *
+     * @param a
+     * @param b
+     */
+    static void thread_join(tnode *a, tnode *b) {
+        if constexpr (threaded) {
+            if (a != nullptr)
+                a->succ = b;
+            if (b != nullptr)
+                b->pred = a;
+        }
+    }
+
+    /**
+     * @brief Rebuild the threads of the whole tree in order, in O(n)
+     *
+     */
+    void thread_reset() {
+        if constexpr (threaded) {
+            tnode *last = nullptr;
+            thread_subtree(rt, last);
+            if (last != nullptr)
+                last->succ = nullptr;
+        }
+    }
+    /**
+     * @brief Thread the nodes of a subtree in order after last, which is updated to the last node of the subtree
+     *
+     * @param cur
+     * @param last
+     */
+    static void thread_subtree(tnode *cur, tnode *&last) {
+        if (cur == nullptr)
+            return;
+        thread_subtree(cur->left, last);
+        cur->pred = last;
+        if (last != nullptr)
+            last->succ = cur;
+        last = cur;
+        thread_subtree(cur->right, last);
+    }
+
+    /**
+     * @brief Recompute the bounds from the root, in O(log n)
+     *
+     */
+    void bounds_reset() {
+        leftmost = rightmost = rt;
+        if (rt == nullptr)
+            return;
+        while (leftmost->left != nullptr)
+            leftmost = leftmost->left;
+        while (rightmost->right != nullptr)
+            rightmost = rightmost->right;
+    }
+
+    /**
+     * @brief Search the position of key from the root
+     *
+     * @param key
+     * @return the node with the key and 0, or the parent to link the key to and the side (-1 for left, 1 for right),
+     *   or nullptr if the tree is empty
+     */
+    pair<tnode *, int> search(const Key &key) const {
+        tnode *cur = rt, *par = nullptr, *same = nullptr;
+        int comp = 0;
+        while (cur != nullptr) {
+            if constexpr (three_way_keys<Key, Key>) {
+                comp = key_compare(key, cur->data.first);
+                if (!comp)
+                    return {cur, 0};
+            } else {
+                // Compare once on each level, and check the equality at the end, as in insert_value()
+                comp = key_less(cur->data.first, key) ? 1 : -1;
+                if (comp < 0)
+                    same = cur;
+            }
+            par = cur;
+            cur = comp > 0 ? cur->right : cur->left;
+        }
+        if (same != nullptr && !key_less(key, same->data.first))
+            return {same, 0};
+        return {par, comp};
+    }
+
+    /**
+     * @brief Search the position of key beside the hint with at most two comparisons, or from the root otherwise
+     *
+     * @param hint the node the key should be beside, or nullptr for the end
+     * @param key
+     * @return the same as search(key)
+     */
+    pair<tnode *, int> search(tnode *hint, const Key &key) const {
+        if (rt == nullptr)
+            return {nullptr, 0};
+        if (hint == nullptr) {
+            tnode *back = last();
+            if (key_less(back->data.first, key))
+                return {back, 1};
+        } else if (key_less(key, hint->data.first)) {
+            // Find the predecessor of hint, which is nullptr if hint is the first one
+            tnode *before = hint->left;
+            if (before != nullptr) {
+                while (before->right != nullptr)
+                    before = before->right;
+            } else {
+                for (before = hint; before->parent != nullptr && before->parent->left == before;)
+                    before = before->parent;
+                before = before->parent;
+            }
+            if (before == nullptr || key_less(before->data.first, key))
+                return hint->left == nullptr ? pair<tnode *, int>(hint, -1) : pair<tnode *, int>(before, 1);
+        } else if (key_less(hint->data.first, key)) {
+            tnode *after = next(hint);
+            if (after == nullptr || key_less(key, after->data.first))
+                return hint->right == nullptr ? pair<tnode *, int>(hint, 1) : pair<tnode *, int>(after, -1);
+        } else {
+            return {hint, 0};
+        }
+        return search(key);
+    }
+
+    /**
+     * @brief Create a node at the position found by search(), constructing the element from args,
+     *   unless the key is there already
+     *
+     * @param pos
+     * @param args
+     * @return the node with the key, and whether it's newly created
+     */
+    template <class... Args> pair<tnode *, bool> node_place(const pair<tnode *, int> &pos, Args &&...args) {
+        if (pos.first == nullptr) {
+            rt = leftmost = rightmost = node_create(nullptr, BLACK, 1, std::forward<Args>(args)...);
+            node_count++;
+            return {rt, true};
+        }
+        if (pos.second == 0)
+            return {pos.first, false};
+        tnode *cur = node_create(nullptr, RED, 1, std::forward<Args>(args)...);
+        return {node_link(pos.first, pos.second < 0, cur), true};
+    }
+
+    /**
+     * @brief Link a created node into the tree, or delete it if its key is there already
+     *
+     * @param cur
+     * @param hint the node to search beside, or nullptr for the end
+     * @param hinted whether to use the hint
+     * @return the node with the key, and whether cur is linked
+     */
+    pair<tnode *, bool> node_insert(tnode *cur, tnode *hint, bool hinted) {
+        // Only the comparisons in the search may throw
+        try {
+            return node_insert(cur, hinted ? search(hint, cur->data.first) : search(cur->data.first));
+        } catch (...) {
+            node_delete(cur);
+            throw;
+        }
+    }
+    pair<tnode *, bool> node_insert(tnode *cur, const pair<tnode *, int> &pos) {
+        if (pos.first == nullptr) {
+            rt = leftmost = rightmost = cur;
+            cur->col = BLACK;
+            cur->parent = nullptr;
+            size_adjust(cur);
+            node_count++;
+            return {cur, true};
+        }
+        if (pos.second == 0) {
+            node_delete(cur);
+            return {pos.first, false};
+        }
+        return {node_link(pos.first, pos.second < 0, cur), true};
+    }
+
+    /**
+     * @brief Fix the missing black node on the path to cur from bottom up, where cur may be a null leaf
+     *
+     * @param cur
+     * @param par the parent of cur
+     */
+    void erase_fixup(tnode *cur, tnode *par) {
+        while (cur != rt && (cur == nullptr || cur->col == BLACK)) {
+            if (cur == par->left) {
+                tnode *bro = par->right;
+                if (bro->col == RED) {
+                    bro->col = BLACK;
+                    par->col = RED;
+                    left_rotate(par);
+                    bro = par->right;
+                }
+                if ((bro->left == nullptr || bro->left->col == BLACK) &&
+                    (bro->right == nullptr || bro->right->col == BLACK)) {
+                    bro->col = RED;
+                    cur = par;
+                    par = cur->parent;
+                    continue;
+                }
+                if (bro->right == nullptr || bro->right->col == BLACK) {
+                    bro->left->col = BLACK;
+                    bro->col = RED;
+                    right_rotate(bro);
+                    bro = par->right;
+                }
+                bro->col = par->col;
+                par->col = BLACK;
+                bro->right->col = BLACK;
+                left_rotate(par);
+            } else {
+                tnode *bro = par->left;
+                if (bro->col == RED) {
+                    bro->col = BLACK;
+                    par->col = RED;
+                    right_rotate(par);
+                    bro = par->left;
+                }
+                if ((bro->left == nullptr || bro->left->col == BLACK) &&
+                    (bro->right == nullptr || bro->right->col == BLACK)) {
+                    bro->col = RED;
+                    cur = par;
+                    par = cur->parent;
+                    continue;
+                }
+                if (bro->left == nullptr || bro->left->col == BLACK) {
+                    bro->right->col = BLACK;
+                    bro->col = RED;
+                    left_rotate(bro);
+                    bro = par->left;
+                }
+                bro->col = par->col;
+                par->col = BLACK;
+                bro->left->col = BLACK;
+                right_rotate(par);
+            }
+            return;
+        }
+        if (cur != nullptr)
+            cur->col = BLACK;
+    }
+
+    /**
+     * @brief Remove the selected node from the tree without destructing it, from bottom up.
+     *
+     * @param cur
+     */
+    void node_unlink(tnode *cur) {
+        // The neighbour of an extreme node is its only child or its parent, so this costs O(1)
+        if (cur == leftmost && cur == rightmost)
+            leftmost = rightmost = nullptr;
+        else if (cur == leftmost)
+            leftmost = next(cur);
+        else if (cur == rightmost)
+            rightmost = prev(cur);
+        if constexpr (threaded) {
+            if (cur->pred != nullptr)
+                cur->pred->succ = cur->succ;
+            if (cur->succ != nullptr)
+                cur->succ->pred = cur->pred;
+            cur->pred = cur->succ = nullptr;
+        }
+        node_cut(cur);
+    }
+
+    /**
+     * @brief Remove the selected node from the structure of the tree, leaving the bounds and the threads alone
+     *
+     * @param cur
+     */
+    void node_cut(tnode *cur) {
+        if (cur->left != nullptr && cur->right != nullptr) {
+            tnode *next = cur->right;
+            while (next->left)
+                next = next->left;
+            node_swap(cur, next);
+        }
+        tnode *child = cur->left == nullptr ? cur->right : cur->left, *par = cur->parent;
+        if (child)
+            child->parent = par;
+        if (par == nullptr)
+            rt = child;
+        else if (par->left == cur)
+            par->left = child;
+        else
+            par->right = child;
+        size_adjust_upward(par, -1);
+        if (cur->col == BLACK) {
+            if (child != nullptr && child->col == RED)
+                child->col = BLACK;
+            else if (par != nullptr)
+                erase_fixup(child, par);
+        }
+        cur->left = cur->right = cur->parent = nullptr;
+        node_count--;
+    }
+
+    /**
+     * @brief Make the selected subtree a standalone one with a black root
+     *
+     * @param cur
+     */
+    static void node_detach(tnode *cur) {
+        if (cur == nullptr)
+            return;
+        cur->parent = nullptr;
+        cur->col = BLACK;
+    }
+
+    /**
+     * @brief Get the black height of a subtree, i.e. the number of black nodes on the path to any leaf
+     *
+     * @param cur
+     * @return int
+     */
+    static int black_height(const tnode *cur) {
+        int height = 0;
+        for (; cur != nullptr; cur = cur->left)
+            height += cur->col == BLACK;
+        return height;
+    }
+
+    /**
+     * @brief Count the nodes of a subtree
+     *
+     * @param cur
+     * @return size_t
+     */
+    static size_t node_count_of(const tnode *cur) {
+        return cur == nullptr ? 0 : 1 + node_count_of(cur->left) + node_count_of(cur->right);
+    }
+
+    /**
+     * @brief Join two standalone subtrees with a middle node, where left < mid < right.
+     *   It goes down the spine of the higher subtree to the black node of the same black height as the lower one,
+     *   and hangs mid there with the lower subtree, so it costs O(|left_height - right_height| + 1).
+     *
+     * @param left
+     * @param left_height
+     * @param mid
+     * @param right
+     * @param right_height
+     * @param height the black height of the joined tree
+     * @return the root of the joined tree
+     */
+    tnode *join_nodes(tnode *left, int left_height, tnode *mid, tnode *right, int right_height, int &height) {
+        mid->col = RED;
+        if (left_height == right_height) {
+            mid->col = BLACK;
+            mid->parent = nullptr;
+            mid->left = left;
+            mid->right = right;
+            if (left)
+                left->parent = mid;
+            if (right)
+                right->parent = mid;
+            size_adjust(mid);
+            height = left_height + 1;
+            return mid;
+        }
+        tnode *saved = rt, *par = nullptr, *cur;
+        if (left_height > right_height) {
+            rt = cur = left;
+            height = left_height;
+            for (int h = left_height; h > right_height || (cur != nullptr && cur->col == RED); cur = cur->right) {
+                h -= cur->col == BLACK;
+                par = cur;
+            }
+            par->right = mid;
+            mid->left = cur;
+            mid->right = right;
+            if (right)
+                right->parent = mid;
+        } else {
+            rt = cur = right;
+            height = right_height;
+            for (int h = right_height; h > left_height || (cur != nullptr && cur->col == RED); cur = cur->left) {
+                h -= cur->col == BLACK;
+                par = cur;
+            }
+            par->left = mid;
+            mid->left = left;
+            mid->right = cur;
+            if (left)
+                left->parent = mid;
+        }
+        mid->parent = par;
+        if (cur)
+            cur->parent = mid;
+        size_adjust(mid);
+        size_adjust_upward(par, subtree_size(mid) - subtree_size(cur));
+        insert_fixup(mid);
+        if (rt->col == RED) {
+            rt->col = BLACK;
+            height++;
+        }
+        tnode *res = rt;
+        rt = saved;
+        return res;
+    }
+
+    /**
+     * @brief Build a balanced subtree of the next count distinct elements in order,
+     *   so that the nodes are allocated in order too
+     *
+     * @param first the next element, which is moved past the elements used
+     * @param last
+     * @param count
+     * @param depth the depth of the subtree root
+     * @param red_depth the depth of the red nodes
+     * @return the root of the subtree
+     */
+    template <class ForwardIt>
+    tnode *build_sorted(ForwardIt &first, const ForwardIt &last, size_t count, int depth, int red_depth) {
+        if (count == 0)
+            return nullptr;
+        tnode *left = build_sorted(first, last, (count - 1) / 2, depth + 1, red_depth), *cur;
+        try {
+            cur = node_create(nullptr, depth == red_depth ? RED : BLACK, count, *first);
+        } catch (...) {
+            node_destruct(left);
+            throw;
+        }
+        cur->left = left;
+        if (left)
+            left->parent = cur;
+        // Skip the equal keys
+        while (++first != last && !key_less(cur->data.first, (*first).first))
+            ;
+        try {
+            cur->right = build_sorted(first, last, count - 1 - (count - 1) / 2, depth + 1, red_depth);
+        } catch (...) {
+            node_destruct(cur);
+            throw;
+        }
+        if (cur->right)
+            cur->right->parent = cur;
+        return cur;
+    }
+
+    /**
+     * @brief Cut the nodes not less than key off the tree, without changing node_count
+     *
+     * @param key
+     * @return the root of the standalone subtree cut off
+     */
+    tnode *split_off(const Key &key) {
+        tnode *root = rt, *left, *right;
+        rt = nullptr;
+        node_detach(root);
+        int left_height, right_height;
+        split_node(root, black_height(root), key, left, left_height, right, right_height);
+        rt = left;
+        return right;
+    }
+
+    /**
+     * @brief Concatenate two standalone subtrees, where left < right, without changing node_count.
+     *   The smallest node of right is taken out as the middle one to join them.
+     *
+     * @param left
+     * @param right
+     * @return the root of the joined tree
+     */
+    tnode *join_trees(tnode *left, tnode *right) {
+        if (left == nullptr || right == nullptr)
+            return left == nullptr ? right : left;
+        tnode *saved = rt, *mid;
+        rt = right;
+        for (mid = right; mid->left != nullptr;)
+            mid = mid->left;
+        // mid stays between left and right in order, so the threads don't change
+        node_cut(mid);
+        node_count++;
+        right = rt;
+        rt = saved;
+        node_detach(left);
+        node_detach(right);
+        int height;
+        return join_nodes(left, black_height(left), mid, right, black_height(right), height);
+    }
+
+    /**
+     * @brief Erase the elements in [lo, *hi), or those not less than lo if hi is nullptr
+     *
+     * @param lo
+     * @param hi
+     * @return the number of elements erased
+     */
+    size_t erase_between(const Key &lo, const Key *hi) {
+        if (rt == nullptr)
+            return 0;
+        tnode *upper = split_off(lo), *mid = upper, *tail;
+        if (hi != nullptr && upper != nullptr) {
+            int mid_height, tail_height;
+            split_node(upper, black_height(upper), *hi, mid, mid_height, tail, tail_height);
+            rt = join_trees(rt, tail);
+        }
+        size_t res = order_statistics ? subtree_size(mid) : node_count_of(mid);
+        node_count -= res;
+        if constexpr (threaded) {
+            if (mid != nullptr) {
+                tnode *lo_node = mid, *hi_node = mid;
+                while (lo_node->left != nullptr)
+                    lo_node = lo_node->left;
+                while (hi_node->right != nullptr)
+                    hi_node = hi_node->right;
+                thread_join(lo_node->pred, hi_node->succ);
+            }
+        }
+        node_destruct(mid);
+        bounds_reset();
+        return res;
+    }
+
+    /**
+     * @brief Split a standalone subtree by key, and join the pieces on the way back up
+     *
+     * @param cur the root of the subtree, which should be black
+     * @param height the black height of the subtree
+     * @param key
+     * @param left the subtree of the keys less than key
+     * @param left_height
+     * @param right the subtree of the keys not less than key
+     * @param right_height
+     */
+    void split_node(tnode *cur, int height, const Key &key, tnode *&left, int &left_height, tnode *&right,
+                    int &right_height) {
+        if (cur == nullptr) {
+            left = right = nullptr;
+            left_height = right_height = 0;
+            return;
+        }
+        tnode *lchild = cur->left, *rchild = cur->right;
+        int lh = height - 1, rh = height - 1;
+        if (lchild != nullptr && lchild->col == RED)
+            lh++;
+        if (rchild != nullptr && rchild->col == RED)
+            rh++;
+        node_detach(lchild);
+        node_detach(rchild);
+        cur->left = cur->right = nullptr;
+        if (key_less(cur->data.first, key)) {
+            tnode *mid;
+            int mh;
+            split_node(rchild, rh, key, mid, mh, right, right_height);
+            left = join_nodes(lchild, lh, cur, mid, mh, left_height);
+        } else {
+            tnode *mid;
+            int mh;
+            split_node(lchild, lh, key, left, left_height, mid, mh);
+            right = join_nodes(mid, mh, cur, rchild, rh, right_height);
+        }
+    }
+
+  private:
+    pool_type pool;
+
+    /**
+     * @brief create a tree node from the pool, with the element constructed from args in place
      *
-     * @param cur
+     * @return tnode*
      */
-    void right_rotate(tnode *cur) {
-        if (cur->left == nullptr)
-            throw custom_exception("The node to rotate (right) doesn't have a left child.");
-        if (cur->parent) {
-            if (is_left(cur))
-                cur->parent->left = cur->left;
-            else
-                cur->parent->right = cur->left;
-        } else {
-            rt = cur->left;
+    template <class... Args> tnode *node_create(tnode *_parent, color _col, int _siz, Args &&...args) {
+        tnode *res = pool.allocate();
+        try {
+            node_traits::construct(pool.get_allocator(), res, _parent, _col, _siz, std::forward<Args>(args)...);
+        } catch (...) {
+            pool.deallocate(res);
+            throw;
         }
-        tnode *tmp = cur->left;
-        tmp->parent = cur->parent;
-        cur->left = tmp->right;
-        if (tmp->right)
-            tmp->right->parent = cur;
-        tmp->right = cur;
-        cur->parent = tmp;
-        size_adjust(cur);
-        size_adjust(tmp);
+        return res;
+    }
+
+    /**
+     * @brief destruct a tree node and give it back to the pool
+     *
+     * @param target
+     */
+    void node_delete(tnode *target) {
+        node_traits::destroy(pool.get_allocator(), target);
+        pool.deallocate(target);
     }
 
-  private:
     /**
      * @brief copy a tree node
      *
@@ -559,7 +2161,7 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
     tnode *node_copy(tnode *target, tnode *_parent = nullptr) {
         if (target == nullptr)
             return nullptr;
-        tnode *tmp = new tnode(target->data, _parent, target->col, target->siz);
+        tnode *tmp = node_create(_parent, target->col, subtree_size(target), target->data);
         tmp->left = node_copy(target->left, tmp);
         tmp->right = node_copy(target->right, tmp);
         return tmp;
@@ -606,7 +2208,8 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
             target->right->parent = target;
         // color and size
         std::swap(cur->col, target->col);
-        std::swap(cur->siz, target->siz);
+        if constexpr (order_statistics)
+            std::swap(cur->siz, target->siz);
     }
 
     /**
@@ -619,10 +2222,26 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
             return;
         node_destruct(target->left);
         node_destruct(target->right);
-        delete target;
+        node_delete(target);
         target = nullptr;
     }
 
+    /**
+     * @brief destruct the whole tree.
+     * If destructing a node does nothing and the chunks aren't shared, the nodes are simply dropped, and their memory
+     * is reclaimed with the chunks of the pool, e.g. a map of trivial types on a std::pmr::monotonic_buffer_resource
+     * costs nothing to destruct. Otherwise the nodes are freed one by one, so that the pools sharing the chunks
+     * can reuse them.
+     *
+     */
+    void node_destruct_all() {
+        if (std::is_trivially_destructible<tnode>::value && allocator_destroys_plainly<node_allocator, tnode>::value &&
+            pool.exclusive())
+            rt = nullptr;
+        else
+            node_destruct(rt);
+    }
+
     /**
      * @brief Judge if a node is the left child of its parent
      * @throw custom_exception when passing the root node
@@ -637,11 +2256,6 @@ template <class Key, class T, class Compare = std::less<Key>> class RBTree {
         return cur->parent->left == cur;
     }
 
-    bool has_black_descendants(tnode *cur) {
-        return ((cur->left && cur->left->col == BLACK) || cur->left == nullptr) &&
-               ((cur->right && cur->right->col == BLACK) || cur->right == nullptr);
-    }
-
     /**
      * @brief Get the sibling of the selected node
      * @throw custom_exception by is_left() when passing the root node
@@ -666,10 +2280,13 @@ template <typename T> struct my_type_traits {
 	using iterator_assignable = typename T::iterator_assignable;
 };
 
-template <class Key, class T, class Compare = std::less<Key>> class map : public RBTree<Key, T, Compare> {
+template <class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>,
+          class Policy = tree_policy<>>
+class map : public RBTree<Key, T, Compare, Allocator, Policy> {
   public:
-    using tnode = typename RBTree<Key, T, Compare>::tnode;
-    using value_type = typename RBTree<Key, T, Compare>::value_type;
+    using tnode = typename RBTree<Key, T, Compare, Allocator, Policy>::tnode;
+    using value_type = typename RBTree<Key, T, Compare, Allocator, Policy>::value_type;
+    using RBTree<Key, T, Compare, Allocator, Policy>::order_statistics;
 
     /**
      * see BidirectionalIterator at CppReference for help.
@@ -701,8 +2318,8 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
         // About value_type: https://blog.csdn.net/u014299153/article/details/72419713
         // About iterator_category: https://en.cppreference.com/w/cpp/iterator
         using difference_type = std::ptrdiff_t;
-        using value_type = typename RBTree<Key, T, Compare>::value_type;
-        using iterator_category = std::output_iterator_tag;
+        using value_type = typename RBTree<Key, T, Compare, Allocator, Policy>::value_type;
+        using iterator_category = std::bidirectional_iterator_tag;
         using pointer = typename std::conditional<const_tag, const value_type *, value_type *>::type;
         using reference = typename std::conditional<const_tag, const value_type &, value_type &>::type;
         using iterator_assignable = typename std::conditional<const_tag, my_false_type, my_true_type>::type;
@@ -759,6 +2376,51 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
          */
         template <bool _const_tag> bool operator==(const base_iterator<_const_tag> &rhs) const { return iter == rhs.iter && ptr == rhs.ptr; }
         template <bool _const_tag> bool operator!=(const base_iterator<_const_tag> &rhs) const { return iter != rhs.iter || ptr != rhs.ptr; }
+        /**
+         * move the iterator by n (which may be negative) in O(log n), with order statistics enabled.
+         * throw invalid_iterator if it goes beyond [begin(), end()].
+         */
+        template <bool enabled = order_statistics> base_iterator &advance(difference_type n) {
+            static_assert(enabled, "advance() requires order statistics, see sjtu::ranked_map");
+            if (iter == nullptr)
+                throw invalid_iterator();
+            difference_type target = static_cast<difference_type>(iter->node_rank(ptr)) + n;
+            if (target < 0 || target > static_cast<difference_type>(iter->size()))
+                throw invalid_iterator();
+            ptr = iter->select(target);
+            return *this;
+        }
+        /**
+         * the distance from rhs to this iterator in O(log n), with order statistics enabled.
+         * throw invalid_iterator if they belong to different maps.
+         */
+        template <bool _const_tag, bool enabled = order_statistics>
+        difference_type operator-(const base_iterator<_const_tag> &rhs) const {
+            static_assert(enabled, "operator-() requires order statistics, see sjtu::ranked_map");
+            if (iter == nullptr || iter != rhs.iter)
+                throw invalid_iterator();
+            return static_cast<difference_type>(iter->node_rank(ptr)) - static_cast<difference_type>(iter->node_rank(rhs.ptr));
+        }
+        /**
+         * the number of steps from first to last, which is found by argument-dependent lookup, e.g.
+         *   using std::distance;
+         *   distance(map.begin(), it);
+         * It takes O(log n) from the subtree sizes with order statistics enabled, and steps through the elements otherwise.
+         * throw invalid_iterator if last cannot be reached from first.
+         */
+        friend difference_type distance(const base_iterator &first, const base_iterator &last) {
+            if constexpr (order_statistics) {
+                difference_type res = last - first;
+                if (res < 0)
+                    throw invalid_iterator();
+                return res;
+            } else {
+                difference_type res = 0;
+                for (base_iterator it = first; it != last; ++it)
+                    res++;
+                return res;
+            }
+        }
         /**
          * some other operator for iterator.
          */        
@@ -768,17 +2430,96 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
 
     using iterator = base_iterator<false>;
     using const_iterator = base_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using node_type = typename RBTree<Key, T, Compare, Allocator, Policy>::node_handle;
+    /**
+     * the result of insert(node_type &&): where the key is, whether the node is inserted,
+     *   and the node itself if it isn't.
+     */
+    struct insert_return_type {
+        iterator position;
+        bool inserted;
+        node_type node;
+    };
+
+    /**
+     * a lazily evaluated view of the elements whose keys are in [lo, hi), which can be used in range-for.
+     *   The bounds are searched only when begin() or end() is called,
+     *   so the view sees the contents of the map at that time.
+     */
+    template <bool const_tag> class range_view {
+        friend class map;
+
+      public:
+        using map_pointer = typename std::conditional<const_tag, const map *, map *>::type;
+        using view_iterator = base_iterator<const_tag>;
+
+        view_iterator begin() const {
+            // An empty interval, including a reversed one, begins at its end
+            if (!container->key_less(lo, hi))
+                return end();
+            return view_iterator(container, container->RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(lo));
+        }
+        view_iterator end() const {
+            return view_iterator(container, container->RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(hi));
+        }
+        bool empty() const { return begin() == end(); }
+        /**
+         * the number of elements in the view in O(log n), with order statistics enabled.
+         */
+        template <bool enabled = order_statistics> size_t size() const { return container->template count_range<enabled>(lo, hi); }
+
+      private:
+        range_view(map_pointer _container, const Key &_lo, const Key &_hi) : container(_container), lo(_lo), hi(_hi) {}
+
+        map_pointer container;
+        // The bounds are copied, since a view in range-for may outlive the temporary keys
+        Key lo, hi;
+    };
 
     /**
      * TODO two constructors
      */
-    map() : RBTree<Key, T, Compare>() {}
-    map(const map &other) : RBTree<Key, T, Compare>(other) {}
+    map() : RBTree<Key, T, Compare, Allocator, Policy>() {}
+    explicit map(const Allocator &alloc) : RBTree<Key, T, Compare, Allocator, Policy>(alloc) {}
+    /**
+     * Constructs an empty map ordered by comp, which may carry its own state, e.g. a collation table.
+     *   Every copy of the map keeps a copy of comp.
+     */
+    explicit map(const Compare &comp, const Allocator &alloc = Allocator())
+        : RBTree<Key, T, Compare, Allocator, Policy>(comp, alloc) {}
+    map(const map &other) : RBTree<Key, T, Compare, Allocator, Policy>(other) {}
+    /**
+     * Takes over the nodes of other in O(1), leaving it empty.
+     */
+    map(map &&other) noexcept(std::is_nothrow_copy_constructible<Compare>::value)
+        : RBTree<Key, T, Compare, Allocator, Policy>(std::move(other)) {}
+    /**
+     * Constructs the map from the elements in [first, last), in O(n) if their keys are ascending.
+     */
+    template <class ForwardIt>
+    map(ForwardIt first, ForwardIt last, const Allocator &alloc = Allocator())
+        : RBTree<Key, T, Compare, Allocator, Policy>(alloc) {
+        RBTree<Key, T, Compare, Allocator, Policy>::assign_sorted(first, last);
+    }
+    template <class ForwardIt>
+    map(ForwardIt first, ForwardIt last, const Compare &comp, const Allocator &alloc = Allocator())
+        : RBTree<Key, T, Compare, Allocator, Policy>(comp, alloc) {
+        RBTree<Key, T, Compare, Allocator, Policy>::assign_sorted(first, last);
+    }
     /**
      * TODO assignment operator
      */
     map &operator=(const map &other) {
-        RBTree<Key, T, Compare>::operator=(other);
+        RBTree<Key, T, Compare, Allocator, Policy>::operator=(other);
+        return *this;
+    }
+    /**
+     * Takes over the nodes of other in O(1) if the allocators allow, or moves the elements one by one otherwise.
+     */
+    map &operator=(map &&other) {
+        RBTree<Key, T, Compare, Allocator, Policy>::operator=(std::move(other));
         return *this;
     }
     /**
@@ -792,16 +2533,31 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
      * If no such element exists, an exception of type `index_out_of_bound'
      */
     T &at(const Key &key) {
-        tnode *res = RBTree<Key, T, Compare>::find(key);
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
         if (res == nullptr)
             throw index_out_of_bound();
-        return RBTree<Key, T, Compare>::find(key)->data.second;
+        return res->data.second;
     }
     const T &at(const Key &key) const {
-        tnode *res = RBTree<Key, T, Compare>::find(key);
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
+        if (res == nullptr)
+            throw index_out_of_bound();
+        return res->data.second;
+    }
+    /**
+     * at() with any key type comparable with Key, if Compare is transparent
+     */
+    template <class K, class C = Compare, class = typename C::is_transparent> T &at(const K &key) {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
         if (res == nullptr)
             throw index_out_of_bound();
-        return RBTree<Key, T, Compare>::find(key)->data.second;
+        return res->data.second;
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent> const T &at(const K &key) const {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
+        if (res == nullptr)
+            throw index_out_of_bound();
+        return res->data.second;
     }
     /**
      * TODO
@@ -809,7 +2565,8 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
      * Returns a reference to the value that is mapped to a key equivalent to key,
      *   performing an insertion if such key does not already exist.
      */
-    T &operator[](const Key &key) { return (RBTree<Key, T, Compare>::insert({key, T()}).first->data).second; }
+    T &operator[](const Key &key) { return RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(key).first->data.second; }
+    T &operator[](Key &&key) { return RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(std::move(key)).first->data.second; }
     /**
      * behave like at() throw index_out_of_bound if such key does not exist.
      */
@@ -817,14 +2574,65 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
     /**
      * return a iterator to the beginning
      */
-    iterator begin() { return iterator(this, RBTree<Key, T, Compare>::first()); }
-    const_iterator cbegin() const { return const_iterator(this, RBTree<Key, T, Compare>::first()); }
+    iterator begin() { return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::first()); }
+    const_iterator cbegin() const { return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::first()); }
     /**
      * return a iterator to the end
      * in fact, it returns past-the-end.
      */
     iterator end() { return iterator{this, nullptr}; }
     const_iterator cend() const { return const_iterator(this, nullptr); }
+    /**
+     * reverse iterators, from the element with the largest key to the one before the first.
+     *   Dereferencing one steps its underlying iterator back, which is O(1) at the end of the map.
+     */
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(cend()); }
+    const_reverse_iterator crend() const { return const_reverse_iterator(cbegin()); }
+
+    /**
+     * access the element with the smallest key, or the largest one by back(), in O(1).
+     *
+     * throw container_is_empty if the map is empty
+     */
+    value_type &front() {
+        if (this->empty())
+            throw container_is_empty();
+        return RBTree<Key, T, Compare, Allocator, Policy>::first()->data;
+    }
+    const value_type &front() const {
+        if (this->empty())
+            throw container_is_empty();
+        return RBTree<Key, T, Compare, Allocator, Policy>::first()->data;
+    }
+    value_type &back() {
+        if (this->empty())
+            throw container_is_empty();
+        return RBTree<Key, T, Compare, Allocator, Policy>::last()->data;
+    }
+    const value_type &back() const {
+        if (this->empty())
+            throw container_is_empty();
+        return RBTree<Key, T, Compare, Allocator, Policy>::last()->data;
+    }
+    /**
+     * erase the element with the smallest key, or the largest one by pop_back(), so that the map works as a
+     *   double-ended priority queue. The node is unlinked at the end of the tree without any comparison,
+     *   which takes amortized O(1) rebalancing.
+     *
+     * throw container_is_empty if the map is empty
+     */
+    void pop_front() {
+        if (this->empty())
+            throw container_is_empty();
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(RBTree<Key, T, Compare, Allocator, Policy>::first());
+    }
+    void pop_back() {
+        if (this->empty())
+            throw container_is_empty();
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(RBTree<Key, T, Compare, Allocator, Policy>::last());
+    }
 
   public:
     /**
@@ -834,19 +2642,181 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
      *   the second one is true if insert successfully, or false.
      */
     pair<iterator, bool> insert(const value_type &value) {
-        auto res = RBTree<Key, T, Compare>::insert(value);
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::insert(value);
+        return {iterator(this, res.first), res.second};
+    }
+    pair<iterator, bool> insert(value_type &&value) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::insert(std::move(value));
+        return {iterator(this, res.first), res.second};
+    }
+    /**
+     * insert an element constructed from value, if its key doesn't exist.
+     *   Unlike the const key of a value_type, the key of a pair<Key, T> && is moved into the node.
+     */
+    template <class P, class = std::enable_if_t<std::is_constructible<value_type, P &&>::value>>
+    pair<iterator, bool> insert(P &&value) { return emplace(std::forward<P>(value)); }
+    /**
+     * insert an element next to hint, taking O(1) comparisons if it belongs there.
+     * Returns an iterator to the inserted element, or to the element with the same key.
+     */
+    iterator insert(const_iterator hint, const value_type &value) {
+        if (hint.iter != this)
+            throw invalid_iterator();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::insert(hint.ptr, value).first);
+    }
+    iterator insert(const_iterator hint, value_type &&value) {
+        if (hint.iter != this)
+            throw invalid_iterator();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::insert(hint.ptr, std::move(value)).first);
+    }
+    template <class P, class = std::enable_if_t<std::is_constructible<value_type, P &&>::value>>
+    iterator insert(const_iterator hint, P &&value) { return emplace_hint(hint, std::forward<P>(value)); }
+    /**
+     * construct an element from args, and insert it next to hint like insert(hint, value).
+     */
+    template <class... Args> iterator emplace_hint(const_iterator hint, Args &&...args) {
+        if (hint.iter != this)
+            throw invalid_iterator();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::emplace_hint(hint.ptr, std::forward<Args>(args)...).first);
+    }
+    /**
+     * construct an element from args in place, and insert it if its key doesn't exist.
+     *   The element is constructed before the search, since the key is only known then.
+     */
+    template <class... Args> pair<iterator, bool> emplace(Args &&...args) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::emplace(std::forward<Args>(args)...);
+        return {iterator(this, res.first), res.second};
+    }
+    /**
+     * insert an element with key and the value constructed from args in place, if key doesn't exist.
+     *   Nothing is constructed if it does.
+     */
+    template <class... Args> pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(key, std::forward<Args>(args)...);
+        return {iterator(this, res.first), res.second};
+    }
+    template <class... Args> pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(std::move(key), std::forward<Args>(args)...);
+        return {iterator(this, res.first), res.second};
+    }
+    /**
+     * assign obj to the value of key if key exists, or insert an element of them otherwise.
+     */
+    template <class M> pair<iterator, bool> insert_or_assign(const Key &key, M &&obj) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(key, std::forward<M>(obj));
+        if (!res.second)
+            res.first->data.second = std::forward<M>(obj);
+        return {iterator(this, res.first), res.second};
+    }
+    template <class M> pair<iterator, bool> insert_or_assign(Key &&key, M &&obj) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::try_emplace(std::move(key), std::forward<M>(obj));
+        if (!res.second)
+            res.first->data.second = std::forward<M>(obj);
         return {iterator(this, res.first), res.second};
     }
     /**
-     * erase the element at pos.
+     * erase the element at pos, and return the iterator following it.
+     *   The node is unlinked where it is, without any comparison, so erasing while iterating costs O(1) amortized
+     *   per element. The other iterators stay valid.
+     *
+     * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
+     */
+    iterator erase(iterator pos) {
+        if (pos.iter != this || pos.ptr == nullptr)
+            throw index_out_of_bound();
+        tnode *after = this->next(pos.ptr);
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(pos.ptr);
+        return iterator(this, after);
+    }
+    iterator erase(const_iterator pos) {
+        if (pos.iter != this || pos.ptr == nullptr)
+            throw index_out_of_bound();
+        tnode *after = this->next(pos.ptr);
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(pos.ptr);
+        return iterator(this, after);
+    }
+    /**
+     * erase the element with key if it exists, and return the number of elements erased (0 or 1).
+     */
+    size_t erase(const Key &key) {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
+        if (res == nullptr)
+            return 0;
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(res);
+        return 1;
+    }
+    /**
+     * erase() with any key type comparable with Key, if Compare is transparent
+     */
+    template <class K, class C = Compare, class = typename C::is_transparent,
+              class = std::enable_if_t<!std::is_convertible<K, iterator>::value && !std::is_convertible<K, const_iterator>::value>>
+    size_t erase(const K &key) {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
+        if (res == nullptr)
+            return 0;
+        RBTree<Key, T, Compare, Allocator, Policy>::erase_node(res);
+        return 1;
+    }
+    /**
+     * erase the elements in [first, last), by cutting them off the tree at once in O(log n).
+     *   It returns last, which is still valid.
+     *
+     * throw if first or last doesn't belong to this, or first == this->end() != last
+     */
+    iterator erase(iterator first, iterator last) {
+        if (first.iter != this || last.iter != this)
+            throw index_out_of_bound();
+        if (first == last)
+            return last;
+        if (first.ptr == nullptr)
+            throw index_out_of_bound();
+        if (last.ptr == nullptr)
+            RBTree<Key, T, Compare, Allocator, Policy>::erase_from(first.ptr->data.first);
+        else
+            RBTree<Key, T, Compare, Allocator, Policy>::erase_range(first.ptr->data.first, last.ptr->data.first);
+        return last;
+    }
+    /**
+     * erase the elements whose keys are in [lo, hi), and return the number of them.
+     *   The range is cut off the tree at once in O(log n), and then destructed in O(k).
+     */
+    size_t erase_range(const Key &lo, const Key &hi) {
+        return RBTree<Key, T, Compare, Allocator, Policy>::erase_range(lo, hi);
+    }
+    /**
+     * unlink the element at pos from the map, and return its node, which can be inserted into another map.
+     *   If the handle is dropped instead, its node is given back to this map for reuse.
      *
      * throw if pos pointed to a bad element (pos == this->end() || pos points an element out of this)
      */
-    void erase(iterator pos) {
+    node_type extract(const_iterator pos) {
         if (pos.iter != this || pos.ptr == nullptr)
             throw index_out_of_bound();
-        RBTree<Key, T, Compare>::erase(pos.ptr->data.first);
+        return RBTree<Key, T, Compare, Allocator, Policy>::extract(pos.ptr);
+    }
+    /**
+     * unlink the element with key from the map and return its node, or return an empty node if there is no such key.
+     */
+    node_type extract(const Key &key) {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::find(key);
+        return res == nullptr ? node_type() : RBTree<Key, T, Compare, Allocator, Policy>::extract(res);
+    }
+    /**
+     * link the node into the map without copying its element, if its key doesn't exist.
+     *   Otherwise the node is given back in the result.
+     */
+    insert_return_type insert(node_type &&node) {
+        auto res = RBTree<Key, T, Compare, Allocator, Policy>::insert(std::move(node));
+        if (res.second || res.first == nullptr)
+            return {iterator(this, res.first), res.second, node_type()};
+        return {iterator(this, res.first), false, std::move(node)};
     }
+    /**
+     * move the elements of source whose keys don't exist in this map, by relinking their nodes.
+     *   The other elements are left in source.
+     */
+    void merge(map &source) { RBTree<Key, T, Compare, Allocator, Policy>::merge(source); }
+    void merge(map &&source) { RBTree<Key, T, Compare, Allocator, Policy>::merge(source); }
 
   public:
     /**
@@ -855,8 +2825,47 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
      * Iterator to an element with key equivalent to key.
      *   If no such element is found, past-the-end (see end()) iterator is returned.
      */
-    iterator find(const Key &key) { return iterator(this, RBTree<Key, T, Compare>::find(key)); }
-    const_iterator find(const Key &key) const { return iterator(this, RBTree<Key, T, Compare>::find(key)); }
+    iterator find(const Key &key) { return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(key)); }
+    const_iterator find(const Key &key) const { return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(key)); }
+    /**
+     * The lookups below also accept any key type comparable with Key if Compare is transparent (e.g. std::less<>),
+     *   which saves converting the key, e.g. building a std::string from a const char *.
+     */
+    template <class K, class C = Compare, class = typename C::is_transparent> iterator find(const K &key) {
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(key));
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent> const_iterator find(const K &key) const {
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(key));
+    }
+    /**
+     * Finds an element with key, starting from finger instead of the root.
+     *   It takes O(log d) steps in most cases, where d is the distance between finger and the element,
+     *   so a series of lookups close to each other is cheaper if each starts from the result of the last one.
+     *   It only pays off for keys a few elements apart, since the upper levels a search from the root passes are cached.
+     *   The end() iterator starts from the last element.
+     */
+    iterator find(const_iterator finger, const Key &key) {
+        if (finger.iter != this)
+            throw invalid_iterator();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(finger.ptr, key));
+    }
+    const_iterator find(const_iterator finger, const Key &key) const {
+        if (finger.iter != this)
+            throw invalid_iterator();
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::find(finger.ptr, key));
+    }
+    /**
+     * Finds the elements with keys[0], ..., keys[n - 1] at once, storing the iterators in out[0], ..., out[n - 1].
+     *   The searches are interleaved so that their cache misses overlap,
+     *   which is faster than calling find() n times when the map is much larger than the cache.
+     */
+    void find_batch(const Key *keys, size_t n, iterator *out) {
+        RBTree<Key, T, Compare, Allocator, Policy>::find_batch(keys, n, [&](size_t i, tnode *res) { out[i] = iterator(this, res); });
+    }
+    void find_batch(const Key *keys, size_t n, const_iterator *out) const {
+        RBTree<Key, T, Compare, Allocator, Policy>::find_batch(keys, n,
+                                                               [&](size_t i, tnode *res) { out[i] = const_iterator(this, res); });
+    }
 
     /**
      * Returns the number of elements with key
@@ -866,10 +2875,175 @@ template <class Key, class T, class Compare = std::less<Key>> class map : public
      * The default method of check the equivalence is !(a < b || b > a)
      */
     size_t count(const Key &key) const { return find(key) == cend() ? 0 : 1; }
+    template <class K, class C = Compare, class = typename C::is_transparent> size_t count(const K &key) const {
+        return RBTree<Key, T, Compare, Allocator, Policy>::find(key) == nullptr ? 0 : 1;
+    }
+
+    /**
+     * Returns an iterator to the first element whose key is not less than key,
+     *   or end() if there's no such element.
+     */
+    iterator lower_bound(const Key &key) { return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key)); }
+    const_iterator lower_bound(const Key &key) const {
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key));
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent> iterator lower_bound(const K &key) {
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key));
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator lower_bound(const K &key) const {
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key));
+    }
+    /**
+     * lower_bound() starting from finger, like find(finger, key).
+     */
+    iterator lower_bound(const_iterator finger, const Key &key) {
+        if (finger.iter != this)
+            throw invalid_iterator();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(finger.ptr, key));
+    }
+    const_iterator lower_bound(const_iterator finger, const Key &key) const {
+        if (finger.iter != this)
+            throw invalid_iterator();
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(finger.ptr, key));
+    }
+    /**
+     * Returns an iterator to the first element whose key is greater than key,
+     *   or end() if there's no such element.
+     */
+    iterator upper_bound(const Key &key) { return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::upper_bound(key)); }
+    const_iterator upper_bound(const Key &key) const {
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::upper_bound(key));
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent> iterator upper_bound(const K &key) {
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::upper_bound(key));
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    const_iterator upper_bound(const K &key) const {
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::upper_bound(key));
+    }
+    /**
+     * Returns the range of elements whose keys are equivalent to key, i.e. [lower_bound(key), upper_bound(key)).
+     *   Since the keys are unique, the range is found by a single descent.
+     */
+    pair<iterator, iterator> equal_range(const Key &key) {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key);
+        if (res != nullptr && !this->key_less(key, res->data.first))
+            return {iterator(this, res), iterator(this, this->next(res))};
+        return {iterator(this, res), iterator(this, res)};
+    }
+    pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+        tnode *res = RBTree<Key, T, Compare, Allocator, Policy>::lower_bound(key);
+        if (res != nullptr && !this->key_less(key, res->data.first))
+            return {const_iterator(this, res), const_iterator(this, this->next(res))};
+        return {const_iterator(this, res), const_iterator(this, res)};
+    }
+    /**
+     * equal_range() with any key type comparable with Key, if Compare is transparent.
+     *   Since such a key may be equivalent to several keys, it takes both bounds.
+     */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    pair<iterator, iterator> equal_range(const K &key) {
+        return {lower_bound(key), upper_bound(key)};
+    }
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    pair<const_iterator, const_iterator> equal_range(const K &key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    /**
+     * Returns a view of the elements whose keys are in [lo, hi).
+     */
+    range_view<false> range(const Key &lo, const Key &hi) { return range_view<false>(this, lo, hi); }
+    range_view<true> range(const Key &lo, const Key &hi) const { return range_view<true>(this, lo, hi); }
+
+  public:
+    /**
+     * Returns the number of elements whose keys are in [lo, hi) in O(log n), with order statistics enabled.
+     *   The elements themselves are never visited.
+     */
+    template <bool enabled = order_statistics> size_t count_range(const Key &lo, const Key &hi) const {
+        static_assert(enabled, "count_range() requires order statistics, see sjtu::ranked_map");
+        if (!this->key_less(lo, hi))
+            return 0;
+        return RBTree<Key, T, Compare, Allocator, Policy>::key_rank(hi) - RBTree<Key, T, Compare, Allocator, Policy>::key_rank(lo);
+    }
+    /**
+     * Returns an iterator to the k-th (0-based) element in O(log n), with order statistics enabled.
+     *   nth(size()) returns end(), and throw index_out_of_bound if k > size().
+     */
+    template <bool enabled = order_statistics> iterator nth(size_t k) {
+        static_assert(enabled, "nth() requires order statistics, see sjtu::ranked_map");
+        if (k > this->size())
+            throw index_out_of_bound();
+        return iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::select(k));
+    }
+    template <bool enabled = order_statistics> const_iterator nth(size_t k) const {
+        static_assert(enabled, "nth() requires order statistics, see sjtu::ranked_map");
+        if (k > this->size())
+            throw index_out_of_bound();
+        return const_iterator(this, RBTree<Key, T, Compare, Allocator, Policy>::select(k));
+    }
+    /**
+     * Returns the number of elements whose keys are less than key in O(log n), with order statistics enabled.
+     */
+    template <bool enabled = order_statistics> size_t rank(const Key &key) const {
+        static_assert(enabled, "rank() requires order statistics, see sjtu::ranked_map");
+        return RBTree<Key, T, Compare, Allocator, Policy>::key_rank(key);
+    }
+    /**
+     * Returns the position of the iterator in O(log n), with order statistics enabled.
+     *   rank(end()) returns size(), and throw invalid_iterator if pos doesn't belong to this.
+     */
+    template <bool enabled = order_statistics> size_t rank(const_iterator pos) const {
+        static_assert(enabled, "rank() requires order statistics, see sjtu::ranked_map");
+        if (pos.iter != this)
+            throw invalid_iterator();
+        return RBTree<Key, T, Compare, Allocator, Policy>::node_rank(pos.ptr);
+    }
+
+  public:
+    /**
+     * Moves the elements whose keys are not less than key into a new map, in O(log n).
+     *   The elements are moved, not copied, but the iterators to them are invalidated.
+     *   Without order statistics, counting the moved elements takes O(k) more.
+     */
+    map split(const Key &key) {
+        map res(this->key_comp(), this->get_allocator());
+        RBTree<Key, T, Compare, Allocator, Policy>::split(key, res);
+        return res;
+    }
+    /**
+     * Moves all the elements of other into this map, in O(log n), and leaves other empty.
+     *   The keys of one map should be all less than those of the other, or runtime_error is thrown.
+     */
+    void join(map &other) { RBTree<Key, T, Compare, Allocator, Policy>::join(other); }
 };
 
 template class map<std::string, int>;
 
+/**
+ * a map whose nodes keep the sizes of their subtrees, which supports rank queries
+ */
+template <class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>>
+using ranked_map = map<Key, T, Compare, Allocator, tree_policy<true>>;
+
+/**
+ * a map whose nodes are linked in order, so that stepping an iterator costs O(1) in the worst case
+ */
+template <class Key, class T, class Compare = std::less<Key>, class Allocator = std::allocator<pair<const Key, T>>>
+using threaded_map = map<Key, T, Compare, Allocator, tree_policy<false, true>>;
+
+namespace pmr {
+/**
+ * a map whose nodes are allocated from a std::pmr::memory_resource, e.g.
+ *   std::pmr::monotonic_buffer_resource arena;
+ *   sjtu::pmr::map<int, int> m(&arena);
+ */
+template <class Key, class T, class Compare = std::less<Key>>
+using map = sjtu::map<Key, T, Compare, std::pmr::polymorphic_allocator<pair<const Key, T>>>;
+} // namespace pmr
+
 } // namespace sjtu
 
 #endif